@@ -0,0 +1,155 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <numeric>
+#include <sstream>
+#include <string_view>
+
+#include "../src/common/crossings.hpp"
+#include "../src/common/instance.hpp"
+#include "../src/common/penalty_graph.hpp"
+#include "../src/exact/exact.hpp"
+#include "../src/graph/graph.hpp"
+#include "../src/reduction/reduction.hpp"
+
+namespace fs = std::filesystem;
+
+namespace {
+double time_ms(const std::function<void()> &f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+vi reduce(const instance &inst, std::vector<instance> &components) {
+    auto identity = [&](const instance &inst) {
+        components.push_back(inst);
+        vi p(inst.n1);
+        std::iota(ALL(p), 0);
+        return p;
+    };
+    return reduction::reduce(inst, identity);
+}
+
+struct sample {
+    std::string instance, phase;
+    std::vector<double> ms;
+};
+
+void write_csv(std::ostream &os, const std::vector<sample> &samples) {
+    os << "instance,phase,reps,mean_ms,stddev_ms,min_ms,max_ms\n";
+    for (const auto &[instance, phase, ms] : samples) {
+        double mean = std::accumulate(ALL(ms), 0.0) / SZ(ms), var = 0;
+        for (double x : ms)
+            var += (x - mean) * (x - mean);
+        os << instance << "," << phase << "," << SZ(ms) << "," << mean << "," << std::sqrt(var / SZ(ms)) << ","
+           << *std::ranges::min_element(ms) << "," << *std::ranges::max_element(ms) << "\n";
+    }
+}
+
+void write_json(std::ostream &os, const std::vector<sample> &samples) {
+    os << "[\n";
+    REP(i, 0, SZ(samples)) {
+        const auto &[instance, phase, ms] = samples[i];
+        double mean = std::accumulate(ALL(ms), 0.0) / SZ(ms), var = 0;
+        for (double x : ms)
+            var += (x - mean) * (x - mean);
+        os << "  {\"instance\": \"" << instance << "\", \"phase\": \"" << phase << "\", \"mean_ms\": " << mean
+           << ", \"stddev_ms\": " << std::sqrt(var / SZ(ms)) << ", \"ms\": [";
+        REP(j, 0, SZ(ms)) os << (j ? ", " : "") << ms[j];
+        os << "]}" << (i + 1 < SZ(samples) ? "," : "") << "\n";
+    }
+    os << "]\n";
+}
+} // namespace
+
+// Times every phase of the exact pipeline on the given instances (or the test corpora) and writes CSV or JSON.
+// Phases on the reduced components (matrix, penalty, cycles) are summed over all components of an instance.
+int main(int argc, char **argv) {
+    int reps = 3, max_n = 5000;
+    bool json = false, solve = true;
+    std::vector<fs::path> paths;
+    REP(i, 1, argc) {
+        std::string_view arg = argv[i];
+        if (arg == "--reps" && i + 1 < argc)
+            reps = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--max-n" && i + 1 < argc)
+            max_n = std::stoi(argv[++i]);
+        else if (arg == "--json")
+            json = true;
+        else if (arg == "--no-solve")
+            solve = false;
+        else
+            paths.emplace_back(arg);
+    }
+    if (paths.empty())
+        paths = {"tests/tiny_test_set", "tests/medium-public", "tests/exact-public"};
+
+    std::vector<fs::path> files;
+    for (const auto &path : paths) {
+        if (fs::is_directory(path)) {
+            for (const auto &entry : fs::directory_iterator(path))
+                if (entry.path().extension() == ".gr")
+                    files.push_back(entry.path());
+        } else
+            files.push_back(path);
+    }
+    std::ranges::sort(files);
+
+    std::vector<sample> samples;
+    for (const auto &file : files) {
+        std::ifstream in(file);
+        std::stringstream buffer;
+        buffer << in.rdbuf();
+        const std::string text = buffer.str();
+
+        std::map<std::string, std::vector<double>> ms;
+        instance inst;
+        for (int rep = 0; rep < reps; rep++) {
+            ms["parse"].push_back(time_ms([&] {
+                std::stringstream ss(text);
+                ss >> inst;
+            }));
+            if (inst.n1 > max_n)
+                break;
+            std::vector<instance> components;
+            ms["reductions"].push_back(time_ms([&] { reduce(inst, components); }));
+
+            double matrix = 0, penalty = 0, cycles = 0;
+            for (const auto &component : components) {
+                cmatrix C, K;
+                matrix += time_ms([&] { C = crossings::matrix(component); });
+                penalty += time_ms([&] { K = penalty_graph(component, C, true); });
+                cycles += time_ms([&] {
+                    std::vector adj(SZ(K), std::vector<bool>(SZ(K)));
+                    REP(i, 0, SZ(K)) REP(j, 0, SZ(K)) adj[i][j] = K[i][j] > 0;
+                    graph::base_cycles(adj, 5000);
+                });
+            }
+            ms["matrix"].push_back(matrix);
+            ms["penalty_graph"].push_back(penalty);
+            ms["cycles"].push_back(cycles);
+
+            if (!solve)
+                continue;
+            vi p;
+            ms["solve"].push_back(time_ms([&] { p = exact::solve(inst); }));
+            ms["count"].push_back(time_ms([&] { crossings::count(inst, p); }));
+        }
+        std::string name = file.parent_path().filename().string() + "/" + file.filename().string();
+        for (auto &[phase, times] : ms)
+            samples.push_back({name, phase, std::move(times)});
+        std::cerr << name << "\n";
+    }
+    if (json)
+        write_json(std::cout, samples);
+    else
+        write_csv(std::cout, samples);
+    return 0;
+}
@@ -7,6 +7,9 @@
 #include <algorithm>
 #include <random>
 #include <queue>
+#include <mutex>
+#include <atomic>
+#include <limits>
 
 
 #include "utile.h"
@@ -97,6 +100,17 @@ public:
 
 };
 
+// Best solution found by any of several solvers whose formulas share the soft variables 1..vars
+// The auxiliary variables above vars may differ between the solvers, so only the values of 1..vars are kept
+struct SharedIncumbent {
+    explicit SharedIncumbent(unsigned int vars) : vars(vars) {}
+
+    const unsigned int vars;
+    std::atomic<t_weight> cost = std::numeric_limits<t_weight>::max();
+    std::mutex mutex;
+    std::vector<bool> solution; // solution[lit] for lit in 1..vars
+};
+
 class EvalMaxSAT {
 
     ///////////////////////////
@@ -135,6 +149,7 @@ class EvalMaxSAT {
     ///
         std::vector<bool> solution;
         t_weight solutionCost = std::numeric_limits<t_weight>::max();
+        SharedIncumbent *_shared = nullptr;
     ///
     //////////////////////////
 private:
@@ -233,6 +248,19 @@ public:
         solver->disconnect_external_propagator();
     }
 
+    void set_solver_option(const char *name, int value) {
+        solver->set_option(name, value);
+    }
+
+    void set_interrupt(const std::atomic<bool> *flag) {
+        solver->set_interrupt(flag);
+    }
+
+    // Exchange the best solution with the other solvers that use the same incumbent
+    void set_shared_incumbent(SharedIncumbent *shared) {
+        _shared = shared;
+    }
+
     void add_observed_var(int lit) {
         solver->add_observed_var(lit);
     }
@@ -364,6 +392,7 @@ public:
         adapt_am1_exact();
         adapt_am1_FastHeuristicV7();
 
+        adoptSharedSolution();
         if(cost >= solutionCost) {
             return true;
         }
@@ -372,6 +401,7 @@ public:
             if(solver->solve()) {
                 solutionCost = cost;
                 solution = solver->getSolution();
+                publishSolution();
                 return true;
             }
             
@@ -418,6 +448,7 @@ public:
             assert( _cardToAdd.size() == 0 );
             assert( _litToRelax.size() == 0 );
 
+            adoptSharedSolution();
             if(cost >= solutionCost) {
                 return true;
             }
@@ -439,6 +470,7 @@ public:
                 if(minWeightToConsider == 1) {
                     solutionCost = cost;
                     solution = solver->getSolution();
+                    publishSolution();
                     return true; // Solution found
                 }
 
@@ -539,6 +571,7 @@ public:
                         MonPrint("cost = ", cost, " + ", minWeight);
                         cost += minWeight;
                         std::cerr << "o " << cost << " " << solutionCost << std::endl;
+                        adoptSharedSolution();
                         if(cost == solutionCost) {
                             MonPrint("c UB == LB");
                             return true;
@@ -573,11 +606,16 @@ public:
                                     auto curSolution = solver->getSolution();
                                     auto curCost = LO.optimize( curSolution, std::min(0.1 * chronoLastOptimize.tacSec(), 60.0) );
 
+                                    bool improved = false;
                                     if(curCost < solutionCost) {
                                         std::cerr << "o " << cost << " " << curCost << std::endl;
                                         solutionCost = curCost;
                                         solution = curSolution;
-
+                                        publishSolution();
+                                        improved = true;
+                                    }
+                                    improved |= adoptSharedSolution();
+                                    if(improved) {
                                         if(harden(assum)) {
                                             assert(_mapWeight2Assum.size());
 
@@ -678,6 +716,32 @@ public:
 
     private:
 
+    // Offer the own solution to the other solvers, to be called whenever solution and solutionCost change
+    void publishSolution() {
+        if(_shared == nullptr || solutionCost >= _shared->cost.load())
+            return;
+        std::lock_guard<std::mutex> lock(_shared->mutex);
+        if(solutionCost >= _shared->cost.load())
+            return;
+        _shared->solution.assign(solution.begin(), solution.begin() + std::min<size_t>(solution.size(), _shared->vars + 1));
+        _shared->solution.resize(_shared->vars + 1);
+        _shared->cost = solutionCost;
+    }
+
+    // Take a better solution of another solver. Its cost is an upper bound whatever the auxiliary variables of this
+    // formula, so it is sound for harden(), and its values of the shared variables are all getValue() reports on them
+    bool adoptSharedSolution() {
+        if(_shared == nullptr || _shared->cost.load() >= solutionCost)
+            return false;
+        std::lock_guard<std::mutex> lock(_shared->mutex);
+        if(_shared->cost.load() >= solutionCost)
+            return false;
+        solutionCost = _shared->cost.load();
+        solution = _shared->solution;
+        MonPrint("c adopt shared solution of cost ", solutionCost);
+        return true;
+    }
+
     int harden(std::set<int> &assum) {
         if(_mapWeight2Assum.size() == 0)
             return 0;
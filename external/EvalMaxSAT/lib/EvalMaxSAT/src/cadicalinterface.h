@@ -1,8 +1,12 @@
 #ifndef CADICALINTERFACE_H
 #define CADICALINTERFACE_H
 
+#include <atomic>
 #include <cmath>
 #include <cassert>
+#include <exception>
+#include <limits>
+#include <memory>
 #include <vector>
 #include <set>
 #include <chrono>
@@ -14,17 +18,31 @@
 namespace {
     struct Timeout : CaDiCaL::Terminator {
         std::chrono::time_point<std::chrono::system_clock, std::chrono::duration<double>> timeout;
-        explicit Timeout(const double timeout) : timeout(std::chrono::system_clock::now() + std::chrono::duration<double>(timeout)) {}
+        const std::atomic<bool> *interrupt;
+        explicit Timeout(const double timeout, const std::atomic<bool> *interrupt = nullptr) : timeout(std::chrono::system_clock::now() + std::chrono::duration<double>(timeout)), interrupt(interrupt) {}
         bool terminate() override {
-            return std::chrono::system_clock::now() >= timeout;
+            return (interrupt && interrupt->load(std::memory_order_relaxed)) || std::chrono::system_clock::now() >= timeout;
         }
     };
 }
 
+// Thrown by the solve calls once the flag given to Solver_cadical::set_interrupt is raised
+struct SolveInterrupted : std::exception {
+    const char *what() const noexcept override { return "solve interrupted"; }
+};
+
 class Solver_cadical {
     CaDiCaL::Solver *solver;
     CaDiCaL::ExternalPropagator * _propagator = nullptr;
     unsigned int nVar=0;
+    const std::atomic<bool> *_interrupt = nullptr;
+    std::unique_ptr<Timeout> _interruptTerminator;
+
+    void checkInterrupt() const {
+        if(_interrupt && _interrupt->load(std::memory_order_relaxed)) {
+            throw SolveInterrupted();
+        }
+    }
 public:
 
     Solver_cadical() : solver(new CaDiCaL::Solver()) {
@@ -86,6 +104,17 @@ public:
         solver->add_observed_var(var);
     }
 
+    void set_option(const char *name, int value) {
+        solver->set(name, value);
+    }
+
+    // Aborts the running search once *flag is set, the interrupted solve call then throws SolveInterrupted
+    void set_interrupt(const std::atomic<bool> *flag) {
+        _interrupt = flag;
+        _interruptTerminator = std::make_unique<Timeout>(std::numeric_limits<double>::infinity(), flag);
+        solver->connect_terminator(_interruptTerminator.get());
+    }
+
     bool solve(const std::vector<bool>& solution) {
         for(unsigned int i=1; i<solution.size(); i++) {
             if(solution[i]) {
@@ -96,6 +125,7 @@ public:
         }
 
         int result = solver->solve();
+        checkInterrupt();
 
         if( !( (result == 10) || (result == 20) ) ) {
             return solve(solution);
@@ -106,6 +136,7 @@ public:
 
     bool solve() {
         int result = solver->solve();
+        checkInterrupt();
 
         //assert( (result == 10) || (result == 20) ); // Bug? Can happen sometimes...
         if( !( (result == 10) || (result == 20) ) ) {
@@ -122,6 +153,7 @@ public:
         }
 
         int result = solver->solve();
+        checkInterrupt();
 
         //assert( (result == 10) || (result == 20) ); // Bug? Can happen sometimes...
         if( !( (result == 10) || (result == 20) ) ) {
@@ -142,6 +174,7 @@ public:
         }
 
         int result = solver->solve();
+        checkInterrupt();
 
         //assert( (result == 10) || (result == 20) ); // Bug? Can happen sometimes...
         if( !( (result == 10) || (result == 20) ) ) {
@@ -162,6 +195,7 @@ public:
         solver->limit("conflicts", confBudget);
 
         auto result = solver->solve();
+        checkInterrupt();
 
         if(result==10) { // Satisfiable
             return 1;
@@ -188,9 +222,13 @@ public:
             solver->assume(lit);
         }
 
-        solver->connect_terminator(new Timeout(timeout_sec));
+        solver->connect_terminator(new Timeout(timeout_sec, _interrupt));
 
         auto result = solver->solve();
+        if(_interruptTerminator) {
+            solver->connect_terminator(_interruptTerminator.get());
+        }
+        checkInterrupt();
 
         if(result==10) { // Satisfiable
             return 1;
@@ -218,9 +256,13 @@ public:
         }
 
         solver->limit("conflicts", confBudget);
-        solver->connect_terminator(new Timeout(timeout_sec));
+        solver->connect_terminator(new Timeout(timeout_sec, _interrupt));
 
         auto result = solver->solve();
+        if(_interruptTerminator) {
+            solver->connect_terminator(_interruptTerminator.get());
+        }
+        checkInterrupt();
 
         if(result==10) { // Satisfiable
             return 1;
@@ -12,7 +12,7 @@ namespace MaLib {
 
     class MonRand {
         static std::mt19937& getGen() {
-            static std::mt19937 gen = std::mt19937();
+            thread_local static std::mt19937 gen = std::mt19937();
             return gen;
         }
     public:
@@ -1,22 +1,175 @@
+#include <fstream>
 #include <iostream>
+#include <numeric>
+#include <string_view>
 
+#include "src/batch/batch.hpp"
+#include "src/common/config.hpp"
+#include "src/common/context.hpp"
+#include "src/common/crossings.hpp"
+#include "src/common/memory_budget.hpp"
 #include "src/common/instance.hpp"
-#include "src/exact/kobayashi_tamaki.hpp"
+#include "src/common/trace.hpp"
+#include "src/exact/cache.hpp"
+#include "src/exact/exact.hpp"
 #include "src/heuristic/heuristic.hpp"
+#include "src/layered/layered.hpp"
 
-int main() {
+int main(int argc, char **argv) {
     std::ios::sync_with_stdio(false);
     std::cin.tie(nullptr);
 
+    config &cfg = config::global();
+    bool stream = false, flush = false;
+    double lns = 0, anneal = 0, tabu = 0;
+    int window = 48;
+    std::string trace_file;
+    bool batch = false;
+    std::vector<std::string> files;
+    bool layered = false, parallel = false, multilevel = false;
+    auto engine = sweep::engine::local;
+    REP(i, 1, argc) {
+        std::string_view arg = argv[i];
+        if (arg == "--stream")
+            stream = true;
+        else if (arg == "--flush")
+            flush = true;
+        else if (arg == "--cache" && i + 1 < argc) {
+            if (!solution_cache::global().open(argv[++i]))
+                std::cerr << "Could not open the solution cache " << argv[i] << "\n";
+        } else if (arg == "--memory" && i + 1 < argc)
+            memory_budget::set_limit(std::stoull(argv[++i]) << 20);
+        else if (arg == "--lns" && i + 1 < argc)
+            lns = std::stod(argv[++i]);
+        else if (arg == "--anneal" && i + 1 < argc)
+            anneal = std::stod(argv[++i]);
+        else if (arg == "--tabu" && i + 1 < argc)
+            tabu = std::stod(argv[++i]);
+        else if (arg == "--window" && i + 1 < argc)
+            window = std::stoi(argv[++i]);
+        else if (arg == "--trace" && i + 1 < argc)
+            trace_file = argv[++i], trace::enable();
+        else if (arg == "--batch")
+            batch = true;
+        else if (arg == "--threads" && i + 1 < argc)
+            cfg.threads = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--time-limit" && i + 1 < argc)
+            cfg.time_limit = std::stod(argv[++i]);
+        else if (arg == "--seed" && i + 1 < argc)
+            cfg.seed = std::stoull(argv[++i]);
+        else if (arg == "--seeding" && i + 1 < argc) {
+            std::string_view name = argv[++i];
+            if (name == "base")
+                context::current().seeding = context::cycle_seeding::base;
+            else if (name == "chordless")
+                context::current().seeding = context::cycle_seeding::chordless;
+            else {
+                std::cerr << "Unknown cycle seeding " << name << ", expected base or chordless\n";
+                return 1;
+            }
+        } else if (arg == "--encoding" && i + 1 < argc) {
+            std::string_view name = argv[++i];
+            if (name == "automatic")
+                context::current().encoding = context::maxsat_encoding::automatic;
+            else if (name == "drop")
+                context::current().encoding = context::maxsat_encoding::drop;
+            else if (name == "ordering")
+                context::current().encoding = context::maxsat_encoding::ordering;
+            else {
+                std::cerr << "Unknown MaxSAT encoding " << name << ", expected automatic, drop or ordering\n";
+                return 1;
+            }
+        } else if (arg == "--portfolio" && i + 1 < argc)
+            context::current().portfolio = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--multilevel")
+            multilevel = true;
+        else if (arg == "--layered")
+            layered = true;
+        else if (arg == "--parallel")
+            parallel = true;
+        else if (arg == "--sweep" && i + 1 < argc) {
+            std::string_view name = argv[++i];
+            if (name == "quick")
+                engine = sweep::engine::quick;
+            else if (name == "exact")
+                engine = sweep::engine::exact;
+            else if (name == "local")
+                engine = sweep::engine::local;
+            else {
+                std::cerr << "Unknown sweep engine " << name << ", expected quick, exact or local\n";
+                return 1;
+            }
+        } else if (arg.starts_with("-") && arg != "-") {
+            std::cerr << "Unknown option " << arg << " or missing value\n";
+            return 1;
+        } else if (arg != "-")
+            files.emplace_back(arg);
+    }
+    if (!batch && !files.empty()) {
+        std::cerr << "Input files are only read with --batch, single instances come from stdin\n";
+        return 1;
+    }
+    auto write_trace = [&] {
+        if (trace_file.empty())
+            return;
+        std::ofstream out(trace_file);
+        trace::write(out);
+    };
+    if (batch) {
+        if (files.empty())
+            batch::solve(std::cin, std::cout, cfg.threads, cfg.time_limit);
+        else
+            batch::solve(files, std::cout, cfg.threads, cfg.time_limit);
+        write_trace();
+        return 0;
+    }
+    if (layered) {
+        layered_graph g;
+        std::cin >> g;
+        std::vector<vi> order(g.layers());
+        REP(l, 0, g.layers()) {
+            order[l].resize(g.size(l));
+            std::iota(ALL(order[l]), 0);
+        }
+        order = sweep::solve(g, order, engine, cfg.time_limit, parallel);
+        REP(l, 0, g.layers()) {
+            REP(i, 0, g.size(l)) std::cout << order[l][i] + g.offset[l] + 1 << (i + 1 < g.size(l) ? " " : "");
+            std::cout << "\n";
+        }
+        write_trace();
+        return 0;
+    }
+    if (stream) {
+        heuristic::streaming(std::cin, std::cout, memory_budget::available());
+        write_trace();
+        return 0;
+    }
+
     instance inst;
     std::cin >> inst;
-    auto res = exact::solve(inst);
-
-    auto heuristic = crossings::count(inst, heuristic::quick(inst));
-    auto exact = crossings::count(inst, res);
-    if (!(exact <= heuristic)) return 0xBAD;
+    context::scope limit(cfg.time_limit);
+    auto print = [&](const vi &p) {
+        for (int v : p)
+            std::cout << v + inst.n0 + 1 << "\n";
+    };
+    auto emit = [&](const vi &block) {
+        print(block);
+        std::cout.flush();
+    };
+    auto res = flush        ? exact::solve(inst, emit)
+               : multilevel ? heuristic::multilevel(inst)
+               : anneal > 0 ? heuristic::anneal(inst, heuristic::quick(inst), anneal)
+               : tabu > 0   ? heuristic::tabu(inst, heuristic::quick(inst), tabu)
+               : lns > 0    ? exact::large_neighborhood(inst, heuristic::quick(inst), window, lns)
+                            : exact::solve(inst);
 
-    REP(i, 0, inst.n1)
-        std::cout << res[i]+inst.n0+1 << "\n";
+    // With --flush the order is already out, dispatch has checked every block of it against the heuristic instead
+    if (!flush) {
+        auto heuristic = crossings::count(inst, heuristic::quick(inst));
+        auto exact = crossings::count(inst, res);
+        if (!(exact <= heuristic)) return 0xBAD;
+        print(res);
+    }
+    write_trace();
     return 0;
 }
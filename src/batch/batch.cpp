@@ -0,0 +1,104 @@
+#include <condition_variable>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <thread>
+
+#include "../common/context.hpp"
+#include "../common/trace.hpp"
+#include "../exact/exact.hpp"
+#include "batch.hpp"
+
+/**
+ * @brief Solve all instances produced by next on a pool of threads
+ *
+ * @param next Returns the next named instance, or std::nullopt when exhausted. Only called by one thread at a time.
+ * @param os Receives, in input order, a "c <name>" line followed by the order of each instance
+ * @param threads Number of worker threads
+ * @param time_limit Per-instance time limit in seconds (<= 0 for none), after which exact::solve falls back to the
+ * heuristic
+ */
+void batch::solve(const source &next, std::ostream &os, int threads, double time_limit) {
+    std::mutex mutex;
+    std::condition_variable done;
+    std::map<int, std::pair<std::string, std::vector<std::string>>> finished;
+    int read = 0, remaining_workers = std::max(threads, 1);
+
+    auto work = [&, parent = context::current()] {
+        context::current() = parent;
+        while (true) {
+            std::unique_lock lock(mutex);
+            auto item = next();
+            if (!item) {
+                remaining_workers--;
+                done.notify_all();
+                return;
+            }
+            int index = read++;
+            lock.unlock();
+
+            TRACE_SCOPE("batch::instance");
+            auto &[name, inst] = *item;
+            vi p;
+            {
+                context::scope limit(time_limit);
+                p = exact::solve(inst);
+            }
+            std::vector<std::string> lines;
+            lines.reserve(p.size());
+            for (int v : p)
+                lines.push_back(std::to_string(v + inst.n0 + 1));
+
+            lock.lock();
+            finished.emplace(index, std::make_pair(std::move(name), std::move(lines)));
+            done.notify_all();
+        }
+    };
+    std::vector<std::thread> workers;
+    REP(t, 0, std::max(threads, 1)) workers.emplace_back(work);
+
+    for (int emitted = 0;;) {
+        std::unique_lock lock(mutex);
+        done.wait(lock, [&] { return finished.contains(emitted) || (!remaining_workers && emitted == read); });
+        if (!finished.contains(emitted))
+            break;
+        auto [name, lines] = std::move(finished[emitted]);
+        finished.erase(emitted++);
+        lock.unlock();
+        os << "c " << name << "\n";
+        for (const auto &line : lines)
+            os << line << "\n";
+        os.flush();
+    }
+    for (auto &worker : workers)
+        worker.join();
+}
+
+void batch::solve(std::istream &is, std::ostream &os, int threads, double time_limit) {
+    int count = 0;
+    solve(
+        [&]() -> std::optional<std::pair<std::string, instance>> {
+            instance inst;
+            if (!(is >> inst))
+                return std::nullopt;
+            return std::make_pair(std::to_string(count++), std::move(inst));
+        },
+        os, threads, time_limit);
+}
+
+void batch::solve(const std::vector<std::string> &files, std::ostream &os, int threads, double time_limit) {
+    size_t index = 0;
+    solve(
+        [&]() -> std::optional<std::pair<std::string, instance>> {
+            while (index < files.size()) {
+                const auto &file = files[index++];
+                std::ifstream in(file);
+                instance inst;
+                if (in >> inst)
+                    return std::make_pair(file, std::move(inst));
+                std::cerr << "Could not read " << file << "\n";
+            }
+            return std::nullopt;
+        },
+        os, threads, time_limit);
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <functional>
+#include <iostream>
+#include <optional>
+#include <string>
+
+#include "../common/instance.hpp"
+#include "../common/macros.hpp"
+
+struct batch {
+    using source = std::function<std::optional<std::pair<std::string, instance>>()>;
+
+    static void solve(const source &next, std::ostream &os, int threads, double time_limit);
+    static void solve(std::istream &is, std::ostream &os, int threads, double time_limit);
+    static void solve(const std::vector<std::string> &files, std::ostream &os, int threads, double time_limit);
+};
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "macros.hpp"
+
+/**
+ * @brief Square matrix of crossing numbers or penalties in the narrowest of 16, 32 or 64 bit entries
+ *
+ * @details The element type is chosen at construction from an upper bound on the finite entries, e.g. the maximum
+ * degree product for a crossing matrix. Entries >= oo are stored as the largest value of the element type and read
+ * back as oo, so penalty graphs stay as narrow as their crossing matrix. Writing a finite entry that does not fit
+ * throws std::overflow_error. Entries are accessed as C[i][j]; hot loops use visit() to get a typed view instead.
+ */
+class cmatrix {
+  public:
+    template <class T> struct view {
+        static constexpr T infinite = std::numeric_limits<T>::max();
+        const T *data;
+        int n;
+        const T *operator[](int i) const { return data + size_t(i) * n; }
+    };
+
+    class reference {
+      public:
+        reference(cmatrix &m, size_t idx) : m(m), idx(idx) {}
+        reference(const reference &) = default;
+        operator crint() const { return m.get(idx); }
+        reference &operator=(crint v) {
+            m.set(idx, v);
+            return *this;
+        }
+        reference &operator=(const reference &rhs) { return *this = crint(rhs); }
+        reference &operator+=(crint v) { return *this = crint(*this) + v; }
+        reference &operator-=(crint v) { return *this = crint(*this) - v; }
+
+      private:
+        cmatrix &m;
+        size_t idx;
+    };
+
+    cmatrix() = default;
+    cmatrix(int n, crint bound) : n(n), width(width_of(bound)) {
+        if (width == 2)
+            d16.resize(size_t(n) * n);
+        else if (width == 4)
+            d32.resize(size_t(n) * n);
+        else
+            d64.resize(size_t(n) * n);
+    }
+
+    // Bytes of an n x n matrix with the given bound, before allocating it
+    static size_t footprint(int n, crint bound) { return size_t(n) * n * width_of(bound); }
+
+    [[nodiscard]] int size() const { return n; }
+    [[nodiscard]] bool empty() const { return n == 0; }
+    [[nodiscard]] int bytes() const { return width; }
+    // Largest finite entry representable by the chosen element type
+    [[nodiscard]] crint bound() const {
+        return width == 2 ? std::numeric_limits<int16_t>::max() - 1
+               : width == 4 ? std::numeric_limits<int32_t>::max() - 1
+                            : std::min<int64_t>(std::numeric_limits<int64_t>::max() - 1, oo - 1);
+    }
+
+    auto operator[](int i) {
+        struct row {
+            cmatrix &m;
+            size_t base;
+            reference operator[](int j) const { return {m, base + j}; }
+        };
+        return row{*this, size_t(i) * n};
+    }
+    auto operator[](int i) const {
+        struct row {
+            const cmatrix &m;
+            size_t base;
+            crint operator[](int j) const { return m.get(base + j); }
+        };
+        return row{*this, size_t(i) * n};
+    }
+
+    template <class F> decltype(auto) visit(F &&f) const {
+        if (width == 2)
+            return f(view<int16_t>{d16.data(), n});
+        if (width == 4)
+            return f(view<int32_t>{d32.data(), n});
+        return f(view<int64_t>{d64.data(), n});
+    }
+
+  private:
+    int n = 0, width = 2;
+    std::vector<int16_t> d16;
+    std::vector<int32_t> d32;
+    std::vector<int64_t> d64;
+
+    static int width_of(crint bound) {
+        return bound < std::numeric_limits<int16_t>::max()   ? 2
+               : bound < std::numeric_limits<int32_t>::max() ? 4
+                                                             : 8;
+    }
+    template <class T> static crint load(T v) { return v == std::numeric_limits<T>::max() ? oo : crint(v); }
+    template <class T> static void store(T &dst, crint v) {
+        if (v >= oo)
+            dst = std::numeric_limits<T>::max();
+        else if (v >= std::numeric_limits<T>::max() || v < std::numeric_limits<T>::min())
+            throw std::overflow_error("cmatrix entry does not fit its element type");
+        else
+            dst = T(v);
+    }
+    [[nodiscard]] crint get(size_t idx) const {
+        return width == 2 ? load(d16[idx]) : width == 4 ? load(d32[idx]) : load(d64[idx]);
+    }
+    void set(size_t idx, crint v) {
+        if (width == 2)
+            store(d16[idx], v);
+        else if (width == 4)
+            store(d32[idx], v);
+        else
+            store(d64[idx], v);
+    }
+};
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <thread>
+
+/**
+ * @brief Run configuration shared by all engines
+ *
+ * @details Set once before solving (main fills it from the command line) and only read afterwards. Every randomized
+ * component draws from random() and every thread pool sizes itself from threads, so two runs with the same
+ * configuration produce the same orders regardless of the thread count. Three things break this guarantee: a time
+ * limit, since engines that run out of time fall back to whatever they have at that moment; a MaxSAT portfolio,
+ * where the first solver to finish wins; and a solution cache file, which returns orders found by earlier runs.
+ */
+struct config {
+    uint64_t seed = 0;
+    int threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    double time_limit = 0; // seconds per instance, <= 0 for none
+
+    // Generator for one randomized component; salt separates components and sub-problems from each other
+    [[nodiscard]] std::mt19937 random(uint64_t salt = 0) const {
+        std::seed_seq seq{uint32_t(seed), uint32_t(seed >> 32), uint32_t(salt), uint32_t(salt >> 32)};
+        return std::mt19937(seq);
+    }
+
+    static config &global() {
+        static config cfg;
+        return cfg;
+    }
+};
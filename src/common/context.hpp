@@ -0,0 +1,50 @@
+#pragma once
+
+#include <chrono>
+
+/**
+ * @brief Per-thread solve context
+ *
+ * @details The engines read the context of the calling thread, so that a library user or the batch driver can bound
+ * a solve without threading parameters through every reduction. Engines that cannot be interrupted check the deadline
+ * before they start, the others poll it, and exact::solve falls back to the heuristic once it has passed.
+ */
+struct context {
+    using clock = std::chrono::steady_clock;
+    // Cycles whose clauses are added to the MaxSAT formula before solving
+    enum class cycle_seeding { base, chordless };
+    // Whether a MaxSAT variable drops a penalty edge or reverses it; automatic decides by the density of free pairs.
+    // drop is the default until the ordering encoding has been checked against the optimal crossings of exact-public
+    enum class maxsat_encoding { automatic, drop, ordering };
+
+    clock::time_point deadline = clock::time_point::max();
+    cycle_seeding seeding = cycle_seeding::base;
+    maxsat_encoding encoding = maxsat_encoding::drop;
+    // Number of differently configured MaxSAT solvers racing on each model, each on its own thread
+    int portfolio = 1;
+
+    [[nodiscard]] bool expired() const { return clock::now() >= deadline; }
+    [[nodiscard]] double remaining() const {
+        if (deadline == clock::time_point::max())
+            return 1e9;
+        return std::chrono::duration<double>(deadline - clock::now()).count();
+    }
+
+    static context &current() {
+        thread_local context ctx;
+        return ctx;
+    }
+
+    // Installs a time limit (seconds, <= 0 for none) on the current thread and restores the previous context on exit
+    struct scope {
+        clock::time_point saved;
+        explicit scope(double seconds) : saved(current().deadline) {
+            if (seconds > 0)
+                current().deadline = clock::now() + std::chrono::duration_cast<clock::duration>(
+                                                        std::chrono::duration<double>(seconds));
+        }
+        ~scope() { current().deadline = saved; }
+        scope(const scope &) = delete;
+        scope &operator=(const scope &) = delete;
+    };
+};
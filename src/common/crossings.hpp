@@ -1,11 +1,14 @@
 #pragma once
 
+#include "cmatrix.hpp"
 #include "instance.hpp"
 #include "macros.hpp"
 
 struct crossings {
     static cmatrix matrix(const instance &inst);
+    static size_t matrix_bytes(const instance &inst);
     static crint count(const cmatrix &C, const vi &p);
+    static std::vector<crint> count(const cmatrix &C, const std::vector<vi> &ps);
     static crint count(const instance &inst, const vi &p);
     static crint lower(const cmatrix &C);
 };
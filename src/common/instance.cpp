@@ -5,8 +5,12 @@
 instance::instance(int n0, int n1) : n0(n0), n1(n1), neighbors(n1), back_neighbors(n0) {}
 
 std::istream &operator>>(std::istream &is, instance &inst) {
-    while (is.peek() != 'p')
+    while (is.peek() != 'p' && is.peek() != std::char_traits<char>::eof())
         is.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    if (is.peek() != 'p') {
+        is.setstate(std::ios::failbit);
+        return is;
+    }
     std::string ocr_line;
     std::getline(is, ocr_line);
     std::stringstream ss(ocr_line);
@@ -21,11 +25,17 @@ std::istream &operator>>(std::istream &is, instance &inst) {
     bool has_cutwidth = !ss.fail();
     inst.neighbors.assign(inst.n1, std::vector<int>());
     inst.back_neighbors.assign(inst.n0, std::vector<int>());
-    if (has_cutwidth)
-        REP(i, 0, inst.n0 + inst.n1) {
-            int x;
-            is >> x;
+    inst.order.clear();
+    if (has_cutwidth) {
+        inst.order.resize(inst.n0 + inst.n1);
+        std::vector<bool> seen(inst.order.size());
+        for (int &x : inst.order) {
+            is >> x, x--;
+            if (!is || x < 0 || x >= SZ(seen) || seen[x])
+                throw std::invalid_argument("Cutwidth order is not a permutation of the vertices");
+            seen[x] = true;
         }
+    }
     REP(i, 0, m) {
         int u, v;
         is >> u >> v;
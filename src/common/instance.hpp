@@ -11,6 +11,7 @@
 struct instance {
     int n0 = 0, n1 = 0;
     vvi neighbors, back_neighbors;
+    vi order; // linear layout of the cutwidth track (0-based, left vertices first), empty if not given
     instance() = default;
     instance(int n0, int n1);
 };
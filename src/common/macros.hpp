@@ -16,4 +16,3 @@ constexpr crint oo = 1e9;
 #endif
 using vi = std::vector<int>;
 using vvi = std::vector<std::vector<int>>;
-using cmatrix = std::vector<std::vector<crint>>;
@@ -0,0 +1,64 @@
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "memory_budget.hpp"
+#include "trace.hpp"
+
+namespace {
+// Smallest limit among the memory controllers that apply to this process, SIZE_MAX if there is none
+size_t detect() {
+    size_t limit = std::numeric_limits<size_t>::max();
+    auto read = [&](const std::string &path) {
+        std::ifstream in(path);
+        // cgroup v2 writes "max" for no limit, which does not parse
+        if (unsigned long long bytes; in >> bytes)
+            limit = std::min<size_t>(limit, bytes);
+    };
+    read("/sys/fs/cgroup/memory.max");
+    read("/sys/fs/cgroup/memory/memory.limit_in_bytes");
+    // Without a cgroup namespace the limit sits at the process's own path in the hierarchy
+    std::ifstream cgroup("/proc/self/cgroup");
+    for (std::string line; std::getline(cgroup, line);)
+        if (line.starts_with("0::/") && line.size() > 4)
+            read("/sys/fs/cgroup" + line.substr(3) + "/memory.max");
+
+    if (rlimit rl; getrlimit(RLIMIT_AS, &rl) == 0 && rl.rlim_cur != RLIM_INFINITY)
+        limit = std::min<size_t>(limit, rl.rlim_cur);
+    if (long pages = sysconf(_SC_PHYS_PAGES), page = sysconf(_SC_PAGE_SIZE); pages > 0 && page > 0)
+        limit = std::min(limit, size_t(pages) * size_t(page));
+    return limit;
+}
+
+std::atomic<size_t> &configured() {
+    static std::atomic<size_t> bytes = [] {
+        size_t limit = detect();
+        return limit == std::numeric_limits<size_t>::max() ? limit : limit / 4 * 3;
+    }();
+    return bytes;
+}
+} // namespace
+
+size_t memory_budget::limit() { return configured().load(); }
+
+void memory_budget::set_limit(size_t bytes) { configured().store(bytes); }
+
+size_t memory_budget::available() {
+    size_t total = limit(), current = used.load();
+    return current >= total ? 0 : total - current;
+}
+
+memory_budget::lease memory_budget::acquire(size_t bytes) {
+    const size_t total = limit();
+    for (size_t current = used.load();;) {
+        if (current > total || bytes > total - current) {
+            TRACE_COUNT("memory_budget.rejected", 1);
+            return {};
+        }
+        if (used.compare_exchange_weak(current, current + bytes))
+            return lease(bytes);
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+/**
+ * @brief Process-wide budget for the large allocations of the engines
+ *
+ * @details The limit is the smallest of the cgroup memory limit, RLIMIT_AS and the physical memory, less a quarter
+ * for everything that is not leased (instances, reductions, the SAT solver's clauses). An engine acquires a lease
+ * for its tables before allocating them and rejects the instance, or downgrades to a smaller configuration, if the
+ * lease is refused. Leases are returned on destruction, so engines running on several threads share the budget.
+ */
+struct memory_budget {
+    class lease {
+      public:
+        lease() = default;
+        lease(lease &&other) noexcept : held(other.held), granted(other.granted) { other.held = 0; }
+        lease &operator=(lease &&other) noexcept {
+            if (this != &other) {
+                release();
+                held = other.held, granted = other.granted;
+                other.held = 0;
+            }
+            return *this;
+        }
+        ~lease() { release(); }
+
+        [[nodiscard]] size_t bytes() const { return held; }
+        explicit operator bool() const { return granted; }
+
+      private:
+        friend struct memory_budget;
+        explicit lease(size_t bytes) : held(bytes), granted(true) {}
+
+        size_t held = 0;
+        bool granted = false;
+        void release() {
+            if (held)
+                used.fetch_sub(held);
+            held = 0;
+        }
+    };
+
+    static size_t limit();
+    // Overrides the detected limit, e.g. from the command line
+    static void set_limit(size_t bytes);
+    [[nodiscard]] static size_t available();
+    // Leases bytes if they fit into what is left of the budget, otherwise returns an empty lease that converts to false
+    [[nodiscard]] static lease acquire(size_t bytes);
+
+  private:
+    static inline std::atomic<size_t> used = 0;
+};
@@ -1,6 +1,8 @@
+#include "cmatrix.hpp"
 #include "macros.hpp"
 
 #include "instance.hpp"
+#include "trace.hpp"
 #include <algorithm>
 #include <cassert>
 #include <set>
@@ -101,10 +103,12 @@ auto cost_vector(const std::vector<int> &a, const std::vector<int> &b, const std
  * @return cmatrix The penalty graph
  *
  * @details Complexity: O(nm) with presolve, O(n^2) without presolve
+ * If the orders forced by the presolve contradict each other, the graph without presolve is returned.
  */
 cmatrix penalty_graph(const instance &inst, const cmatrix &C, bool presolve) {
+    TRACE_SCOPE("penalty_graph");
     int n = SZ(C);
-    cmatrix K(n, std::vector<crint>(n));
+    cmatrix K(n, C.bound());
     REP(i, 0, n) {
         REP(j, 0, n) {
             if (C[i][j] == 0 && C[j][i] == 0)
@@ -186,7 +190,11 @@ cmatrix penalty_graph(const instance &inst, const cmatrix &C, bool presolve) {
         REP(j, 0, n) {
             if (!reachability[i][j])
                 continue;
-            if (K[j][i] >= oo) exit(100); // We commited a cycle
+            // The forced orders of the presolve close a cycle, fall back to the graph without them
+            if (K[j][i] >= oo) {
+                TRACE_COUNT("penalty_graph.presolve_cycles", 1);
+                return penalty_graph(inst, C, false);
+            }
             assert(K[j][i] < oo);
             if (0 < K[i][j] && K[i][j] < oo) {
                 K[i][j] = oo;
@@ -0,0 +1,64 @@
+#include "trace.hpp"
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+struct event {
+    const char *name;
+    trace::clock::time_point start, end;
+};
+
+struct buffer {
+    int tid;
+    std::vector<event> events;
+    std::unordered_map<const char *, long long> counters;
+};
+
+std::mutex registry_mutex;
+std::vector<std::shared_ptr<buffer>> registry;
+const trace::clock::time_point epoch = trace::clock::now();
+
+buffer &local() {
+    thread_local std::shared_ptr<buffer> b = [] {
+        std::lock_guard lock(registry_mutex);
+        auto b = std::make_shared<buffer>();
+        b->tid = static_cast<int>(registry.size());
+        registry.push_back(b);
+        return b;
+    }();
+    return *b;
+}
+
+double micros(trace::clock::time_point t) { return std::chrono::duration<double, std::micro>(t - epoch).count(); }
+} // namespace
+
+void trace::count(const char *name, long long n) { local().counters[name] += n; }
+
+void trace::complete(const char *name, clock::time_point start, clock::time_point end) {
+    local().events.push_back({name, start, end});
+}
+
+void trace::write(std::ostream &os) {
+    std::lock_guard lock(registry_mutex);
+    std::map<std::string, long long> counters;
+    os << "{\"traceEvents\": [\n";
+    for (const auto &b : registry) {
+        for (const auto &[name, start, end] : b->events)
+            os << "{\"name\": \"" << name << "\", \"ph\": \"X\", \"pid\": 0, \"tid\": " << b->tid
+               << ", \"ts\": " << micros(start) << ", \"dur\": " << micros(end) - micros(start) << "},\n";
+        for (const auto &[name, n] : b->counters)
+            counters[name] += n;
+    }
+    os << "{\"name\": \"counters\", \"ph\": \"C\", \"pid\": 0, \"tid\": 0, \"ts\": " << micros(clock::now())
+       << ", \"args\": {";
+    for (bool first = true; const auto &[name, n] : counters) {
+        os << (first ? "" : ", ") << "\"" << name << "\": " << n;
+        first = false;
+    }
+    os << "}}\n], \"displayTimeUnit\": \"ms\"}\n";
+}
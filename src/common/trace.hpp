@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <ostream>
+
+#ifdef CROSSY_TRACE
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name) trace::scope TRACE_CONCAT(trace_scope_, __LINE__)(name)
+#define TRACE_COUNT(name, n)                                                                                           \
+    do {                                                                                                               \
+        if (trace::enabled())                                                                                          \
+            trace::count(name, n);                                                                                     \
+    } while (false)
+#else
+#define TRACE_SCOPE(name)                                                                                              \
+    do {                                                                                                               \
+    } while (false)
+#define TRACE_COUNT(name, n)                                                                                           \
+    do {                                                                                                               \
+    } while (false)
+#endif
+
+/**
+ * @brief Scoped timers and counters, written as a Chrome trace (chrome://tracing, Perfetto)
+ *
+ * @details The TRACE_* macros compile to nothing unless CROSSY_TRACE is defined. If it is, they cost a relaxed load
+ * until trace::enable() is called. Events are buffered per thread and only merged by trace::write.
+ */
+struct trace {
+    using clock = std::chrono::steady_clock;
+
+    static inline std::atomic<bool> active = false;
+
+    static void enable() { active.store(true, std::memory_order_relaxed); }
+    static bool enabled() { return active.load(std::memory_order_relaxed); }
+    static void count(const char *name, long long n);
+    static void complete(const char *name, clock::time_point start, clock::time_point end);
+    static void write(std::ostream &os);
+
+    struct scope {
+        const char *name;
+        clock::time_point start;
+        explicit scope(const char *name) : name(name), start(enabled() ? clock::now() : clock::time_point()) {}
+        ~scope() {
+            if (start != clock::time_point())
+                complete(name, start, clock::now());
+        }
+        scope(const scope &) = delete;
+        scope &operator=(const scope &) = delete;
+    };
+};
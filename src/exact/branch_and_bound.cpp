@@ -0,0 +1,120 @@
+#include <bit>
+#include <cstdint>
+#include <unordered_map>
+
+#include "../common/context.hpp"
+#include "../common/crossings.hpp"
+#include "../common/trace.hpp"
+#include "../heuristic/heuristic.hpp"
+#include "exact.hpp"
+
+/**
+ * @brief Depth-first branch and bound over the order of the right vertices
+ *
+ * @param inst The instance, at most 64 right vertices
+ * @param C The crossing matrix of inst
+ * @param K The presolved penalty graph of C
+ * @param lower A lower bound on the crossings, e.g. exact::lower_bound
+ * @return An optimal order, or an empty vector if the node limit was exceeded
+ *
+ * @details The order is built from left to right. A node is described by its placed set S (a bitmask) and the cost
+ * of the prefix. Its bound adds the exact cost of all pairs between S and the remaining vertices and the pairwise
+ * minimum (or the forced cost) of all pairs among the remaining vertices. Vertices are only placed after their
+ * forced predecessors in the penalty graph, an adjacent swap that strictly improves the prefix is never explored,
+ * and a prefix is dropped if a cheaper prefix with the same placed set was already expanded. The search stops as soon
+ * as an order meets lower, which the pairwise bound of the root alone rarely reaches.
+ */
+vi exact::branch_and_bound(const instance &inst, const cmatrix &C, const cmatrix &K, crint lower) {
+    TRACE_SCOPE("exact::branch_and_bound");
+    using mask = uint64_t;
+    const int n = inst.n1;
+    if (n > 64)
+        return {};
+
+    std::vector<mask> pred(n);
+    cmatrix pair(n, C.bound());
+    REP(i, 0, n) REP(j, 0, n) {
+        if (i == j)
+            continue;
+        if (K[j][i] >= oo)
+            pred[i] |= mask(1) << j;
+        pair[i][j] = K[i][j] >= oo ? C[i][j] : K[j][i] >= oo ? C[j][i] : std::min(C[i][j], C[j][i]);
+    }
+
+    vi best = heuristic::quick(inst);
+    heuristic::greedy_switch(best, C);
+    crint best_cost = crossings::count(C, best);
+    if (best_cost <= lower)
+        return best;
+    const vi order = best;
+
+    std::vector<crint> in(n);
+    crint cost = 0, cross = 0, rest = 0;
+    REP(i, 0, n) REP(j, i + 1, n) rest += pair[i][j];
+
+    const mask all = n == 64 ? ~mask(0) : (mask(1) << n) - 1;
+    const size_t memo_limit = 1 << 22;
+    std::unordered_map<mask, crint> memo;
+    long long nodes = 0;
+    const long long node_limit = 2e6;
+    vi prefix;
+    prefix.reserve(n);
+
+    auto place = [&](int v, mask R) {
+        cost += in[v];
+        cross -= in[v];
+        for (mask r = R; r; r &= r - 1) {
+            int w = std::countr_zero(r);
+            in[w] += C[v][w];
+            cross += C[v][w];
+            rest -= pair[v][w];
+        }
+    };
+    auto unplace = [&](int v, mask R) {
+        for (mask r = R; r; r &= r - 1) {
+            int w = std::countr_zero(r);
+            in[w] -= C[v][w];
+            cross -= C[v][w];
+            rest += pair[v][w];
+        }
+        cross += in[v];
+        cost -= in[v];
+    };
+
+    auto dfs = [&](auto &&self, mask S, int last) -> bool {
+        if (++nodes > node_limit || (nodes % 4096 == 0 && context::current().expired()))
+            return false;
+        if (S == all) {
+            if (cost < best_cost)
+                best_cost = cost, best = prefix;
+            return true;
+        }
+        if (auto it = memo.find(S); it != memo.end() && it->second <= cost)
+            return true;
+        if (memo.size() < memo_limit)
+            memo[S] = cost;
+        for (int v : order) {
+            mask V = mask(1) << v;
+            if ((S & V) || (pred[v] & ~S))
+                continue;
+            if (last != -1 && !(pred[v] >> last & 1) && C[v][last] < C[last][v])
+                continue;
+            mask R = all & ~S & ~V;
+            place(v, R);
+            prefix.push_back(v);
+            bool ok = cost + cross + rest >= best_cost || self(self, S | V, v);
+            prefix.pop_back();
+            unplace(v, R);
+            if (!ok)
+                return false;
+            if (best_cost <= lower)
+                return true;
+        }
+        return true;
+    };
+    bool solved = dfs(dfs, 0, -1);
+    TRACE_COUNT("exact::branch_and_bound.nodes", nodes);
+    if (!solved)
+        return {};
+    return best;
+}
@@ -0,0 +1,174 @@
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../common/trace.hpp"
+#include "cache.hpp"
+
+namespace {
+// Vertices kept in the in-process LRU
+constexpr size_t CAPACITY = 1 << 24;
+constexpr char MAGIC[8] = {'c', 'r', 'o', 's', 's', 'y', 'c', '1'};
+
+// File record: key, n1 and a checksum of the order, followed by the order as n1 uint32_t
+struct header {
+    uint64_t lo, hi;
+    uint32_t n1, check;
+};
+static_assert(sizeof(header) == 24);
+
+uint64_t mix(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111eb;
+    return x ^ (x >> 31);
+}
+
+uint32_t checksum(const solution_cache::key &k, const uint32_t *p, uint32_t n) {
+    uint64_t h = k.lo ^ k.hi;
+    REP(i, 0, int(n)) h = mix(h + p[i]);
+    return uint32_t(h ^ (h >> 32));
+}
+} // namespace
+
+/**
+ * @brief Hash of n0, n1 and the neighbour lists
+ *
+ * @details Two independently seeded 64-bit chains over the same words; the lists are sorted by construction of the
+ * reductions, so equal instances get equal keys.
+ */
+solution_cache::key solution_cache::fingerprint(const instance &inst) {
+    uint64_t lo = 0x9e3779b97f4a7c15, hi = 0x6a09e667f3bcc909;
+    auto add = [&](uint64_t x) {
+        lo = mix(lo ^ x);
+        hi = mix(hi + x * 0xff51afd7ed558ccd);
+    };
+    add(inst.n0), add(inst.n1);
+    for (const auto &row : inst.neighbors) {
+        add(uint64_t(SZ(row)) << 32);
+        for (int v : row)
+            add(v);
+    }
+    return {lo, hi};
+}
+
+solution_cache::~solution_cache() {
+    if (mapped)
+        munmap(const_cast<char *>(mapped), mapped_size);
+    if (fd >= 0)
+        close(fd);
+}
+
+/**
+ * @details Records are read lazily from the mapping. A torn record at the end, left by a process that died while
+ * appending, is cut off, so that the next append starts at a record boundary.
+ */
+bool solution_cache::open(const std::string &path) {
+    std::lock_guard lock(mutex);
+    if (fd >= 0)
+        return false;
+    int f = ::open(path.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+    struct stat st;
+    if (f < 0 || fstat(f, &st) < 0) {
+        if (f >= 0)
+            close(f);
+        return false;
+    }
+    size_t length = st.st_size;
+    if (length == 0) {
+        if (write(f, MAGIC, sizeof MAGIC) != sizeof MAGIC) {
+            close(f);
+            return false;
+        }
+        fd = f;
+        return true;
+    }
+    void *m = length < sizeof MAGIC ? MAP_FAILED : mmap(nullptr, length, PROT_READ, MAP_SHARED, f, 0);
+    if (m == MAP_FAILED || std::memcmp(m, MAGIC, sizeof MAGIC)) {
+        if (m != MAP_FAILED)
+            munmap(m, length);
+        close(f);
+        return false;
+    }
+    fd = f, mapped = static_cast<const char *>(m), mapped_size = length;
+    size_t pos = sizeof MAGIC;
+    while (pos + sizeof(header) <= length) {
+        header h;
+        std::memcpy(&h, mapped + pos, sizeof h);
+        auto order = reinterpret_cast<const uint32_t *>(mapped + pos + sizeof h);
+        key k{h.lo, h.hi};
+        if (length - pos - sizeof h < size_t(h.n1) * 4 || checksum(k, order, h.n1) != h.check)
+            break;
+        records.emplace(k, std::pair{order, h.n1});
+        pos += sizeof h + size_t(h.n1) * 4;
+    }
+    if (pos != length && ftruncate(fd, pos) < 0)
+        std::cerr << "Could not truncate the torn end of " << path << "\n";
+    TRACE_COUNT("solution_cache.records", SZ(records));
+    return true;
+}
+
+std::optional<vi> solution_cache::find(const instance &inst) {
+    key k = fingerprint(inst);
+    std::lock_guard lock(mutex);
+    if (auto it = entries.find(k); it != entries.end()) {
+        lru.splice(lru.begin(), lru, it->second);
+        TRACE_COUNT("solution_cache.hits", 1);
+        return it->second->second;
+    }
+    if (auto it = records.find(k); it != records.end()) {
+        auto [order, n1] = it->second;
+        // A record of another length or that is no permutation comes from a hash collision or a damaged file. It counts
+        // as a miss and is dropped, so that insert can replace it
+        bool valid = n1 == uint32_t(inst.n1);
+        std::vector<bool> seen(valid ? n1 : 0);
+        for (uint32_t i = 0; valid && i < n1; i++) {
+            valid = order[i] < n1 && !seen[order[i]];
+            if (valid)
+                seen[order[i]] = true;
+        }
+        if (valid) {
+            vi p(order, order + n1);
+            remember(k, p);
+            TRACE_COUNT("solution_cache.file_hits", 1);
+            return p;
+        }
+        records.erase(it);
+        TRACE_COUNT("solution_cache.invalid_records", 1);
+    }
+    TRACE_COUNT("solution_cache.misses", 1);
+    return std::nullopt;
+}
+
+void solution_cache::insert(const instance &inst, const vi &p) {
+    key k = fingerprint(inst);
+    std::lock_guard lock(mutex);
+    if (entries.contains(k) || records.contains(k))
+        return;
+    remember(k, p);
+    if (fd < 0)
+        return;
+    // One write per record, so that records of processes sharing the file do not interleave
+    std::vector<uint32_t> buffer(sizeof(header) / 4 + p.size());
+    std::copy(ALL(p), buffer.begin() + sizeof(header) / 4);
+    header h{k.lo, k.hi, uint32_t(p.size()), checksum(k, buffer.data() + sizeof(header) / 4, uint32_t(p.size()))};
+    std::memcpy(buffer.data(), &h, sizeof h);
+    size_t bytes = buffer.size() * 4;
+    if (write(fd, buffer.data(), bytes) != ssize_t(bytes))
+        std::cerr << "Could not append to the solution cache\n";
+}
+
+void solution_cache::remember(const key &k, vi p) {
+    size += p.size();
+    lru.emplace_front(k, std::move(p));
+    entries[k] = lru.begin();
+    while (size > CAPACITY && SZ(lru) > 1) {
+        size -= lru.back().second.size();
+        entries.erase(lru.back().first);
+        lru.pop_back();
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+#include "../common/instance.hpp"
+#include "../common/macros.hpp"
+
+/**
+ * @brief Optimal orders of reduced instances, keyed by a 128-bit hash of the instance
+ *
+ * @details The reductions relabel every sub-instance canonically, so a component that reappears in another layer,
+ * batch entry or run is byte-identical and hits the cache. Entries live in an in-process LRU and, once a file is
+ * opened, in an append-only file of fixed-layout records that is memory-mapped when opened. Only optimal orders may be
+ * inserted. All members are thread-safe.
+ */
+struct solution_cache {
+    struct key {
+        uint64_t lo, hi;
+        bool operator==(const key &) const = default;
+    };
+
+    static key fingerprint(const instance &inst);
+
+    // Maps the records of path (created if missing) and appends new entries to it; returns false if that failed
+    bool open(const std::string &path);
+    std::optional<vi> find(const instance &inst);
+    void insert(const instance &inst, const vi &p);
+
+    solution_cache() = default;
+    ~solution_cache();
+    solution_cache(const solution_cache &) = delete;
+    solution_cache &operator=(const solution_cache &) = delete;
+
+    static solution_cache &global() {
+        static solution_cache cache;
+        return cache;
+    }
+
+  private:
+    struct hash {
+        size_t operator()(const key &k) const { return k.lo; }
+    };
+    using entry = std::pair<key, vi>;
+
+    void remember(const key &k, vi p);
+
+    std::mutex mutex;
+    std::list<entry> lru; // most recently used first
+    std::unordered_map<key, std::list<entry>::iterator, hash> entries;
+    size_t size = 0; // vertices in lru
+    // Records of the mapped file by key, pointing at the order and its length
+    std::unordered_map<key, std::pair<const uint32_t *, uint32_t>, hash> records;
+    int fd = -1;
+    const char *mapped = nullptr;
+    size_t mapped_size = 0;
+};
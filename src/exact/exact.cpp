@@ -1,27 +1,186 @@
+#include <bit>
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+#include "../common/config.hpp"
+#include "../common/context.hpp"
 #include "../common/crossings.hpp"
+#include "../common/memory_budget.hpp"
+#include "../common/penalty_graph.hpp"
+#include "../common/trace.hpp"
 #include "../graph/graph.hpp"
 #include "../heuristic/heuristic.hpp"
 #include "../reduction/reduction.hpp"
+#include "cache.hpp"
 #include "exact.hpp"
 
+namespace {
+// Smaller components are solved faster than they are looked up
+constexpr int CACHED = 16;
+
+// The engine dispatch for one reduced component; width is the cutwidth bound of the whole instance. optimal is
+// cleared if the order comes from a fallback
+vi dispatch(const instance &inst, int width, bool &optimal) {
+    if (context::current().expired()) {
+        TRACE_COUNT("exact::solve.timeouts", 1);
+        optimal = false;
+        return heuristic::quick(inst);
+    }
+    try {
+        if (int pw = graph::pathwidth(inst); pw <= width || (pw < 40 && (1ll << pw) * inst.n1 <= crint(5e5)))
+            if (auto ans = exact::kobayashi_tamaki(inst); !ans.empty())
+                return ans;
+    } catch (const std::exception &) {}
+    // C and K stay alive while the engines below build their own tables
+    auto matrices = memory_budget::acquire(2 * crossings::matrix_bytes(inst));
+    if (!matrices) {
+        TRACE_COUNT("exact::solve.memory_fallbacks", 1);
+        optimal = false;
+        return heuristic::quick(inst);
+    }
+    const cmatrix C = crossings::matrix(inst);
+    vi upper = heuristic::quick(inst);
+    heuristic::greedy_switch(upper, C);
+    const cmatrix K = penalty_graph(inst, C, true);
+    const crint lower = exact::lower_bound(C, K);
+    if (crossings::count(C, upper) == lower) {
+        TRACE_COUNT("exact::solve.lower_bound_hits", 1);
+        return upper;
+    }
+    // Forced orders let vertices leave the interface early, retry with the width the gate allows
+    if (int max_width = std::min(29, int(std::bit_width(uint64_t(5e5 / inst.n1))) - 1); max_width >= 0)
+        try {
+            if (auto ans = exact::kobayashi_tamaki(inst, C, K, max_width); !ans.empty()) {
+                TRACE_COUNT("exact::solve.forced_width_hits", 1);
+                return ans;
+            }
+        } catch (const std::exception &) {}
+    if (inst.n1 <= 64)
+        if (auto ans = exact::branch_and_bound(inst, C, K, lower); !ans.empty())
+            return ans;
+    if (context::current().expired()) {
+        TRACE_COUNT("exact::solve.timeouts", 1);
+        optimal = false;
+        return upper;
+    }
+    auto ans = exact::maxsat(inst);
+    // MaxSAT gives up if its tables do not fit the memory budget
+    if (ans.empty() || crossings::count(C, ans) > crossings::count(C, upper)) {
+        TRACE_COUNT("exact::solve.maxsat_failures", 1);
+        optimal = false;
+        return upper;
+    }
+    TRACE_COUNT("exact::solve.maxsat_gap", crossings::count(C, ans) - lower);
+    TRACE_COUNT("exact::solve.heuristic_gap", crossings::count(C, upper) - lower);
+    return ans;
+}
+
+// dispatch behind the solution cache
+vi solve_block(const instance &inst, int width) {
+    auto &cache = solution_cache::global();
+    if (inst.n1 >= CACHED)
+        if (auto p = cache.find(inst))
+            return *p;
+    bool optimal = true;
+    vi p = dispatch(inst, width, optimal);
+    if (optimal && inst.n1 >= CACHED)
+        cache.insert(inst, p);
+    return p;
+}
+} // namespace
+
 vi exact::solve(const instance &inst) {
-    return reduction::isolated(inst, [](const instance &inst) {
-        return reduction::merge_twins(inst, [](const instance &inst) {
-            return reduction::components(inst, [](const instance &inst) {
-                return reduction::merge_twins(inst, [](const instance &inst) {
-                    try {
-                        if (int pw = graph::pathwidth(inst); pw < 40 && (1ll << pw) * inst.n1 <= crint(5e5))
-                            if (auto ans = exact::kobayashi_tamaki(inst); !ans.empty())
-                                return ans;
-                    } catch (const std::exception &) {}
-                    auto ans = maxsat(inst);
-                    std::cerr << "Exact: " << crossings::count(inst, ans) - crossings::lower(crossings::matrix(inst)) << "\n";
-                    std::cerr << "Heuristic: " << crossings::count(inst, heuristic::quick(inst)) - crossings::lower(crossings::matrix(inst)) << "\n";
-                    if (ans.empty() || crossings::count(inst, ans) > crossings::count(inst, heuristic::quick(inst)))
-                        exit(42);
-                    return ans;
-                });
-            });
-        });
-    });
+    // A layout of small cutwidth bounds the pathwidth of every part, so Kobayashi-Tamaki runs in time exponential only
+    // in the given parameter and is preferred over the size-based gate
+    const int width = std::min(graph::cutwidth(inst), 16);
+    return reduction::reduce(inst, [width](const instance &inst) { return solve_block(inst, width); });
+}
+
+/**
+ * @brief exact::solve that hands out the order block by block as soon as each block is final
+ *
+ * @param emit Called with consecutive blocks of the order, from the calling thread and in order; their concatenation
+ * is the returned order
+ * @return The same order as emitted
+ *
+ * @details The instance is reduced as in exact::solve: isolated vertices are set aside and twins merged, then the
+ * blocks are the components of reduction::blocks, followed by the isolated vertices. They are solved on
+ * config::global().threads threads, handed out in order so that the front of the order finishes first, and an
+ * emission buffer holds finished blocks until all blocks before them are out. Every block is emitted with its twin
+ * classes expanded. Blocks started after the deadline of the context get the heuristic order, so a time limit still
+ * yields a complete order whose prefix is exact.
+ */
+vi exact::solve(const instance &inst, const std::function<void(const vi &)> &emit) {
+    const int width = std::min(graph::cutwidth(inst), 16);
+    vi remaining, isolated;
+    REP(v, 0, inst.n1) {
+        if (inst.neighbors[v].empty())
+            isolated.push_back(v);
+        else
+            remaining.push_back(v);
+    }
+    // twins holds the twin classes of the remaining vertices in vertex ids of inst, blocks those of the merged instance
+    vvi twins, blocks;
+    std::vector<instance> parts;
+    if (!remaining.empty()) {
+        const instance rest = reduction::split(inst, {remaining})[0];
+        twins = reduction::twins(rest);
+        const instance reduced = reduction::merge(rest, twins);
+        TRACE_COUNT("reduction::merge_twins.merged", rest.n1 - reduced.n1);
+        for (auto &group : twins)
+            for (int &v : group)
+                v = remaining[v];
+        blocks = reduction::blocks(reduced);
+        parts = reduction::split(reduced, blocks);
+    }
+
+    std::mutex mutex;
+    std::condition_variable done;
+    std::vector<std::optional<vi>> finished(SZ(blocks));
+    if (!isolated.empty())
+        finished.emplace_back(std::move(isolated));
+    int next = 0;
+    auto work = [&, parent = context::current()] {
+        context::current() = parent;
+        while (true) {
+            std::unique_lock lock(mutex);
+            if (next == SZ(blocks))
+                return;
+            int k = next++;
+            lock.unlock();
+
+            TRACE_SCOPE("exact::solve.block");
+            vi p = blocks[k];
+            if (SZ(p) > 1) {
+                p = reduction::merge_twins(parts[k], [width](const instance &inst) { return solve_block(inst, width); });
+                for (int &u : p)
+                    u = blocks[k][u];
+            }
+            vi expanded;
+            for (int u : p)
+                expanded.insert(expanded.end(), ALL(twins[u]));
+
+            lock.lock();
+            finished[k] = std::move(expanded);
+            done.notify_all();
+        }
+    };
+    std::vector<std::thread> workers;
+    REP(t, 0, std::min(config::global().threads, SZ(blocks))) workers.emplace_back(work);
+
+    vi res;
+    res.reserve(inst.n1);
+    REP(k, 0, SZ(finished)) {
+        std::unique_lock lock(mutex);
+        done.wait(lock, [&] { return finished[k].has_value(); });
+        vi p = std::move(*finished[k]);
+        lock.unlock();
+        emit(p);
+        res.insert(res.end(), ALL(p));
+    }
+    for (auto &worker : workers)
+        worker.join();
+    return res;
 }
@@ -1,12 +1,19 @@
 #pragma once
 
 #include <chrono>
+#include <functional>
 
+#include "../common/cmatrix.hpp"
 #include "../common/instance.hpp"
 #include "../common/macros.hpp"
 
 struct exact {
     static vi kobayashi_tamaki(const instance &inst);
+    static vi kobayashi_tamaki(const instance &inst, const cmatrix &C, const cmatrix &K, int max_width = 30);
     static vi maxsat(const instance &inst);
+    static vi branch_and_bound(const instance &inst, const cmatrix &C, const cmatrix &K, crint lower = 0);
     static vi solve(const instance &inst);
+    static vi solve(const instance &inst, const std::function<void(const vi &)> &emit);
+    static vi large_neighborhood(const instance &inst, vi p, int window, double seconds);
+    static crint lower_bound(const cmatrix &C, const cmatrix &K, int max_cycles = 1e5);
 };
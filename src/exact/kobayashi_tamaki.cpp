@@ -1,4 +1,5 @@
 #include <algorithm>
+#include <bit>
 #include <cassert>
 #include <cstdint>
 #include <numeric>
@@ -7,6 +8,8 @@
 #include "../common/crossings.hpp"
 #include "../common/instance.hpp"
 #include "../common/macros.hpp"
+#include "../common/memory_budget.hpp"
+#include "../common/trace.hpp"
 #include "exact.hpp"
 
 struct event {
@@ -28,13 +31,18 @@ struct event {
 
 // Kobayashi, Y., & Tamaki, H. (2014). A Fast and Simple Subexponential Fixed Parameter Algorithm for One-Sided Crossing
 // Minimization. Algorithmica, 72(3), 778–790. https://doi.org/10.1007/s00453-014-9872-x
-vi exact::kobayashi_tamaki(const instance &inst) {
+//
+// With a presolved penalty graph K, a vertex y leaves the interface right after the last introduction of a vertex w
+// with K[y][w] < oo instead of at its rightmost neighbour: every vertex introduced later is forced behind y anyway.
+// The crossings of such a vertex with the vertices forgotten before its introduction are then no longer zero and are
+// charged when it is introduced. Returns an empty order if the width exceeds max_width.
+vi exact::kobayashi_tamaki(const instance &inst, const cmatrix &C, const cmatrix &K, int max_width) {
+    TRACE_SCOPE("exact::kobayashi_tamaki");
 #ifdef LARGE_WEIGHTS
     using crossings_t = uint64_t;
 #else
     using crossings_t = uint32_t;
 #endif
-    const cmatrix C = crossings::matrix(inst);
     vi solution;
 
     std::vector<event> events;
@@ -52,31 +60,64 @@ vi exact::kobayashi_tamaki(const instance &inst) {
     sort(ALL(events));
 
     const int T = std::ssize(events);
+    if (!K.empty()) {
+        vi last(inst.n1), active;
+        REP(t, 0, T) {
+            int w = events[t].y;
+            if (events[t].is_deletion) {
+                std::erase(active, w);
+                continue;
+            }
+            for (int y : active)
+                if (K[y][w] < oo)
+                    last[y] = t;
+            last[w] = t;
+            active.push_back(w);
+        }
+        std::vector<std::pair<int, event>> keyed(T);
+        REP(t, 0, T) keyed[t] = {events[t].is_deletion ? 2 * last[events[t].y] + 1 : 2 * t, events[t]};
+        std::ranges::stable_sort(keyed, {}, &std::pair<int, event>::first);
+        REP(t, 0, T) events[t] = keyed[t].second;
+    }
+    // A vertex is in the interface from its introduction up to, but not including, its deletion
     std::vector<int> depth(T);
     std::vector<bool> is_introduce(T);
+    for (int t = 0, width = 0; t < T; t++) {
+        is_introduce[t] = !events[t].is_deletion;
+        depth[t] = width += is_introduce[t] ? 1 : -1;
+    }
+    int pathwidth = T ? *std::max_element(ALL(depth)) : 0;
+    TRACE_COUNT("exact::kobayashi_tamaki.width", pathwidth);
+    if (pathwidth > max_width)
+        return {};
+
+    // Can be optimized to use only O(T * pathwidth) memory
+    auto table = memory_budget::acquire(size_t(T) * (inst.n1 * sizeof(crossings_t) + pathwidth * sizeof(int)));
+    if (!table)
+        return {};
     std::vector<std::vector<int>> interface(T);
     for (int t = 0; t < T; t++) {
-        auto [y, x, is_leaf, is_deletion] = events[t];
-        is_introduce[t] = !is_deletion;
         if (!is_introduce[t])
             continue;
-        for (int tt = t; events[tt].y != y || tt == t; tt++)
-            interface[tt].push_back(y);
+        for (int tt = t; events[tt].y != events[t].y || tt == t; tt++)
+            interface[tt].push_back(events[t].y);
     }
-    for (int t = 0; t < T; t++)
-        depth[t] = std::ssize(interface[t]);
-
-    // Can be optimized to use only O(T * pathwidth) memory
     std::vector cL(T, std::vector<crossings_t>(inst.n1));
+    vi forgotten;
     for (int t = 1; t < T; t++) {
         int y = events[t].y;
         if (is_introduce[t]) {
             for (int v : interface[t])
                 cL[t][v] = cL[t - 1][v];
             cL[t][y] = 0;
-        } else
+            if (!K.empty())
+                for (int f : forgotten)
+                    cL[t][y] += C[f][y];
+        } else {
             for (int v : interface[t])
                 cL[t][v] = cL[t - 1][v] + C[y][v];
+            forgotten.push_back(y);
+        }
     }
 
     auto insert_bit = [](int S, int i) {
@@ -88,15 +129,9 @@ vi exact::kobayashi_tamaki(const instance &inst) {
 
     auto subset_crossings = [&](int t) {
         std::vector cS(depth[t], std::vector<crossings_t>(1 << depth[t]));
-        for (int j = 0; j < depth[t]; j++) {
-            for (int S = 0; S < 1 << depth[t]; S++) {
-                crossings_t sum = 0;
-                for (int i = 0; i < depth[t]; i++)
-                    if (S & (1 << i))
-                        sum += C[interface[t][i]][interface[t][j]];
-                cS[j][S] = sum;
-            }
-        }
+        for (int j = 0; j < depth[t]; j++)
+            for (int S = 1; S < 1 << depth[t]; S++)
+                cS[j][S] = cS[j][S & (S - 1)] + C[interface[t][std::countr_zero(unsigned(S))]][interface[t][j]];
         return cS;
     };
 
@@ -159,16 +194,16 @@ vi exact::kobayashi_tamaki(const instance &inst) {
         return solution;
     };
 
-    int pathwidth = *std::max_element(ALL(depth));
-    if (pathwidth > 30)
-        return {};
-
-    const long long MEMLIMIT = 7ll << 30; // 7 GiB
+    // The tables of one interval are alive at the same time; split into intervals when they exceed the budget
+    long long need = 0;
+    REP(t, 0, T) need += static_cast<long long>(sizeof(crossings_t)) << depth[t];
+    auto tables = memory_budget::acquire(std::min<size_t>(need, memory_budget::available()));
+    const long long budget = tables.bytes();
     std::vector<std::pair<int, int>> partitions;
     for (int l = 0; l < T;) {
         int r = l;
         long long memory_partition = 0;
-        while (r < T && memory_partition + (2ll << depth[r]) <= MEMLIMIT)
+        while (r < T && memory_partition + (2ll << depth[r]) <= budget)
             memory_partition += static_cast<long long>(sizeof(crossings_t)) << depth[r++];
         partitions.emplace_back(l, r);
         if (r <= l)
@@ -184,3 +219,10 @@ vi exact::kobayashi_tamaki(const instance &inst) {
     return solution;
 #undef all
 }
+
+vi exact::kobayashi_tamaki(const instance &inst) {
+    auto matrix = memory_budget::acquire(crossings::matrix_bytes(inst));
+    if (!matrix)
+        return {};
+    return kobayashi_tamaki(inst, crossings::matrix(inst), {});
+}
@@ -0,0 +1,91 @@
+#include <algorithm>
+#include <atomic>
+#include <numeric>
+#include <thread>
+
+#include "../common/config.hpp"
+#include "../common/crossings.hpp"
+#include "../common/penalty_graph.hpp"
+#include "../common/trace.hpp"
+#include "../graph/graph.hpp"
+#include "../reduction/reduction.hpp"
+#include "exact.hpp"
+
+namespace {
+vi solve_window(const instance &inst) {
+    vi p(inst.n1);
+    std::iota(ALL(p), 0);
+    // A window of isolated vertices has no crossings, and the engines below expect edges
+    if (inst.n0 == 0)
+        return p;
+    vi ans;
+    try {
+        if (int pw = graph::pathwidth(inst); pw < 40 && (1ll << pw) * inst.n1 <= crint(5e5))
+            ans = exact::kobayashi_tamaki(inst);
+    } catch (const std::exception &) {}
+    const cmatrix C = crossings::matrix(inst);
+    if (ans.empty()) {
+        const cmatrix K = penalty_graph(inst, C, true);
+        ans = exact::branch_and_bound(inst, C, K, exact::lower_bound(C, K));
+    }
+    if (ans.empty())
+        return p;
+    auto cost = crossings::count(C, {p, ans});
+    return cost[1] < cost[0] ? ans : p;
+}
+} // namespace
+
+/**
+ * @brief Improve an order by solving windows of consecutive vertices to optimality
+ *
+ * @param inst The instance
+ * @param p The initial order
+ * @param window Number of consecutive vertices per window, at most 64
+ * @param seconds Time budget
+ * @return An order with at most as many crossings as p
+ *
+ * @details The crossings between a window and the vertices outside of it do not depend on the order inside the
+ * window, so each window is solved exactly on its sub-instance and spliced back. The windows of one pass are disjoint,
+ * cut out together by reduction::split and solved in parallel; consecutive passes shift the windows by half their
+ * width. The search stops at the time limit or when a full shift cycle does not change the order.
+ */
+vi exact::large_neighborhood(const instance &inst, vi p, int window, double seconds) {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double>(seconds);
+    window = std::clamp(window, 2, 64);
+    const int threads = config::global().threads;
+    for (int pass = 0, stable = 0; stable < 2 && std::chrono::steady_clock::now() < deadline; pass++) {
+        std::vector<std::pair<int, int>> segments;
+        for (int l = 0, r = pass % 2 ? window / 2 : window; l < inst.n1; l = r, r += window)
+            segments.emplace_back(l, std::min(r, inst.n1));
+
+        vvi windows;
+        windows.reserve(segments.size());
+        for (auto [l, r] : segments)
+            windows.emplace_back(p.begin() + l, p.begin() + r);
+        const auto parts = reduction::split(inst, windows);
+
+        std::atomic<int> next = 0;
+        std::atomic<bool> changed = false;
+        auto work = [&] {
+            for (int i; (i = next++) < SZ(segments) && std::chrono::steady_clock::now() < deadline;) {
+                TRACE_SCOPE("exact::large_neighborhood.window");
+                if (SZ(windows[i]) <= 1)
+                    continue;
+                vi q = solve_window(parts[i]);
+                if (!std::ranges::is_sorted(q)) {
+                    for (int &u : q)
+                        u = windows[i][u];
+                    std::ranges::copy(q, p.begin() + segments[i].first);
+                    changed = true;
+                }
+            }
+        };
+        std::vector<std::thread> workers;
+        REP(t, 1, std::min(threads, SZ(segments))) workers.emplace_back(work);
+        work();
+        for (auto &worker : workers)
+            worker.join();
+        stable = changed ? 0 : stable + 1;
+    }
+    return p;
+}
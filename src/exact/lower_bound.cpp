@@ -0,0 +1,46 @@
+#include <algorithm>
+
+#include "../common/crossings.hpp"
+#include "../common/trace.hpp"
+#include "../graph/graph.hpp"
+#include "exact.hpp"
+
+/**
+ * @brief Compute a lower bound on the number of crossings
+ *
+ * @param C The crossing matrix
+ * @param K The (presolved) penalty graph of C
+ * @param max_cycles Maximum number of cycles used for the packing
+ * @return A lower bound on the crossings of every order respecting the forced pairs of K
+ *
+ * @details Complexity: O(n^3 + max_cycles)
+ * On top of crossings::lower, every order consistent with K pays the full cost of each forced pair and has to drop at
+ * least one edge of every cycle of K. The latter is bounded from below by greedily packing the 3- and 4-cycles of
+ * graph::base_cycles against the residual edge weights.
+ */
+crint exact::lower_bound(const cmatrix &C, const cmatrix &K, int max_cycles) {
+    TRACE_SCOPE("exact::lower_bound");
+    const int n = SZ(K);
+    crint bound = crossings::lower(C);
+    std::vector adj(n, std::vector<bool>(n));
+    REP(i, 0, n) REP(j, 0, n) {
+        adj[i][j] = K[i][j] > 0;
+        if (K[i][j] >= oo && C[i][j] > C[j][i])
+            bound += C[i][j] - C[j][i];
+    }
+
+    cmatrix residual = K;
+    for (const auto &cycle : graph::base_cycles(adj, max_cycles)) {
+        crint w = oo;
+        REP(i, 0, SZ(cycle)) w = std::min(w, crint(residual[cycle[i]][cycle[(i + 1) % SZ(cycle)]]));
+        if (w <= 0 || w >= oo)
+            continue;
+        bound += w;
+        REP(i, 0, SZ(cycle)) {
+            auto r = residual[cycle[i]][cycle[(i + 1) % SZ(cycle)]];
+            if (r < oo)
+                r -= w;
+        }
+    }
+    return bound;
+}
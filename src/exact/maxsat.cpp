@@ -1,5 +1,13 @@
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+#include "../common/config.hpp"
+#include "../common/context.hpp"
 #include "../common/crossings.hpp"
+#include "../common/memory_budget.hpp"
 #include "../common/penalty_graph.hpp"
+#include "../common/trace.hpp"
 #include "../graph/graph.hpp"
 #include "EvalMaxSAT.h"
 #include "exact.hpp"
@@ -60,18 +68,21 @@ struct OnlineCycleDetection {
         [[nodiscard]] inline bool empty() const { return head == tail; }
     };
     ring_buffer hq;
-    std::vector<std::vector<uint16_t>> g;
+    std::vector<std::vector<uint16_t>> g, gT;
     std::vector<std::pair<uint16_t, uint16_t>> history;
     std::vector<uint16_t> history_e;
     std::vector<std::pair<uint32_t, uint32_t>> commits;
-    std::vector<uint16_t> L, par;
-    std::vector<uint32_t> par_time;
-    uint32_t mtime = 0;
+    std::vector<uint16_t> L;
+    // g[u][k] is a spine edge iff k < spine[u], since kept edges are only ever appended after them
+    vi spine, dist, via[2];
+    std::vector<uint32_t> seen[2];
+    uint32_t stamp = 0;
 
     OnlineCycleDetection(const vvb &adj, const vvb &fixed)
-        : n(std::ssize(adj)), hq(n * n), g(n), L(n), par(n), par_time(n) {
-        history.reserve(n * n + 100);
-        history_e.reserve(n * n + 100);
+        : n(std::ssize(adj)), hq(n * n), g(n), gT(n), L(n), spine(n), dist(n), via{vi(n), vi(n)},
+          seen{std::vector<uint32_t>(n), std::vector<uint32_t>(n)} {
+        history.reserve(size_t(n) * n + 100);
+        history_e.reserve(size_t(n) * n + 100);
         vvb is_spine(n, std::vector<bool>(n));
         for (int i = 0; i < n; i++)
             for (int j = 0; j < n; j++)
@@ -79,12 +90,12 @@ struct OnlineCycleDetection {
 
         auto red = transitive_reduction(is_spine);
 
-        vvi gT(n, std::vector<int>());
         for (int i = 0; i < n; i++)
             for (int j = 0; j < n; j++)
                 if (red[i][j]) {
                     g[i].emplace_back(j);
                     gT[j].emplace_back(i);
+                    spine[i]++;
                 }
 
         std::vector<bool> visited(n);
@@ -103,28 +114,61 @@ struct OnlineCycleDetection {
                 dfs(i);
     }
 
-    auto naive_bfs(int s, int t) {
-        std::vector<bool> vis(n);
-        std::vector path(n, -1);
-        std::queue<int> q;
-        q.push(s);
-        vis[s] = true;
+    /**
+     * @brief Path from s to t in the current graph that uses the fewest kept edges
+     *
+     * @details 0-1 BFS in which spine edges are free, since they never appear in a clause. Returns the vertices of
+     * the path from s to t, or nothing if t is unreachable.
+     */
+    vi shortest_path(int s, int t) {
+        ++stamp;
+        auto &vis = seen[0];
+        std::deque<int> q{s};
+        vis[s] = stamp, dist[s] = 0;
         while (!q.empty()) {
             int u = q.front();
-            q.pop();
-            for (int v : g[u]) {
-                if (!vis[v]) {
-                    vis[v] = true;
-                    path[v] = u;
-                    q.push(v);
-                }
+            q.pop_front();
+            if (u == t)
+                break;
+            for (int k = 0; k < std::ssize(g[u]); k++) {
+                int v = g[u][k], w = k >= spine[u];
+                if (vis[v] == stamp && dist[v] <= dist[u] + w)
+                    continue;
+                vis[v] = stamp, dist[v] = dist[u] + w, via[0][v] = u;
+                w ? q.push_back(v) : q.push_front(v);
             }
         }
-        std::vector<std::vector<int>> out(1);
-        for (int u = t; u != -1; u = path[u])
-            out.back().emplace_back(u);
-        std::reverse(out.back().begin(), out.back().end());
-        out.back().emplace_back(s);
+        if (vis[t] != stamp)
+            return {};
+        vi path{t};
+        while (path.back() != s)
+            path.push_back(via[0][path.back()]);
+        std::ranges::reverse(path);
+        return path;
+    }
+
+    /**
+     * @brief Breadth-first search from s over g (dir = 0) or gT (dir = 1) that stops after limit vertices
+     *
+     * @details Returns the vertices in visiting order. via[dir][v] is the neighbour of v on the search tree towards
+     * s and stays valid until the next search in the same direction.
+     */
+    vi reach(int s, int dir, int limit) {
+        ++stamp;
+        const auto &h = dir ? gT : g;
+        auto &vis = seen[dir];
+        vi out{s};
+        vis[s] = stamp;
+        for (int i = 0; i < std::ssize(out) && std::ssize(out) < limit; i++)
+            for (int v : h[out[i]]) {
+                if (vis[v] == stamp)
+                    continue;
+                vis[v] = stamp;
+                via[dir][v] = out[i];
+                out.push_back(v);
+                if (std::ssize(out) == limit)
+                    break;
+            }
         return out;
     }
 
@@ -133,7 +177,6 @@ struct OnlineCycleDetection {
         L[x] = y;
     }
     bool prop(uint16_t s, uint16_t t) {
-        mtime++;
         if (L[s] < L[t])
             return false;
         set(t, L[s] + 1);
@@ -144,8 +187,6 @@ struct OnlineCycleDetection {
             for (uint16_t v : g[u]) {
                 if (L[u] < L[v])
                     continue;
-                if (par_time[v] != mtime)
-                    par[v] = u, par_time[v] = mtime;
                 if (v == s)
                     return true;
                 set(v, L[u] + 1);
@@ -158,22 +199,15 @@ struct OnlineCycleDetection {
     std::optional<vvi> add_edge(int a, int b) {
         auto time = history.size();
         if (prop(a, b)) {
-            uint16_t v = a;
-            vi cycle{b};
-            while (v != b) {
-                cycle.emplace_back(v);
-                if (par_time[v] != mtime)
-                    exit(42);
-                v = par[v];
-            }
-            cycle.emplace_back(b);
-            std::ranges::reverse(cycle);
-
             while (history.size() > time)
                 L[history.back().first] = history.back().second, history.pop_back();
+            // The levels only witness that b reaches a; close the cycle along the path with the fewest kept edges
+            vi cycle = shortest_path(b, a);
+            cycle.push_back(b);
             return vvi{cycle};
         }
         g[a].emplace_back(b);
+        gT[b].emplace_back(a);
         history_e.emplace_back(a);
         return std::nullopt;
     }
@@ -183,8 +217,12 @@ struct OnlineCycleDetection {
         commits.resize(t);
         while (history.size() > ht)
             L[history.back().first] = history.back().second, history.pop_back();
-        while (history_e.size() > het)
-            g[history_e.back()].pop_back(), history_e.pop_back();
+        while (history_e.size() > het) {
+            auto &out = g[history_e.back()];
+            gT[out.back()].pop_back();
+            out.pop_back();
+            history_e.pop_back();
+        }
     }
 
     void commit() { commits.emplace_back(history.size(), history_e.size()); }
@@ -192,49 +230,144 @@ struct OnlineCycleDetection {
 
 class DAGPropagator : public EvalMaxSAT::ExternalPropagator {
   public:
+    // Ancestors and descendants inspected per kept edge when looking for implied drops
+    static constexpr int REACH = 64;
+#ifdef CROSSY_PROPAGATE
+    static constexpr bool PROPAGATE = true;
+#else
+    // The reason protocol has not been run against CaDiCaL yet, so implied drops are only learnt from cycles
+    static constexpr bool PROPAGATE = false;
+#endif
+
     OnlineCycleDetection ocd;
+    // var[u][v] is the literal that rules out the edge u -> v, 0 if the edge is fixed or cannot occur
     vvi c, var;
     std::vector<std::pair<int, int>> lookup;
+    // With the ordering encoding a dropped edge is reversed rather than removed
+    bool ordering;
+    // value[x] is +1 (true), -1 (false) or 0 (unassigned); trail and levels undo it on backtrack
+    std::vector<int8_t> value;
+    vi trail, implied;
+    std::vector<size_t> levels;
+    // reasons[lit] is the clause that explains lit when it was last queued and how many of its literals are handed out.
+    // It outlives backtracks: with chronological backtracking lit can stay assigned while CaDiCaL asks for its reason
+    // lazily. Queueing lit again replaces the clause, which only happens once lit is unassigned
+    std::unordered_map<int, std::pair<vi, int>> reasons;
 
-    DAGPropagator(const vvb &adj, const vvb &fixed) : ocd(adj, fixed), var(size(adj), vi(size(adj))) {
+    DAGPropagator(const vvb &adj, const vvb &fixed, bool ordering)
+        : ocd(adj, fixed), var(size(adj), vi(size(adj))), ordering(ordering) {
         int n = std::ssize(adj);
         for (int i = 0; i < n; i++) {
             for (int j = 0; j < n; j++) {
                 if (adj[i][j] && !fixed[i][j]) {
                     lookup.emplace_back(i, j);
                     var[i][j] = lookup.size();
+                    if (ordering)
+                        var[j][i] = -var[i][j];
                 }
             }
         }
+        value.resize(lookup.size() + 1);
+    }
+
+    [[nodiscard]] int val(int lit) const { return lit > 0 ? value[lit] : -value[-lit]; }
+
+    /**
+     * @brief Queue the drops implied by the kept edge a -> b
+     *
+     * @details Every ancestor x of a now reaches every descendant y of b, so keeping y -> x would close a cycle. The
+     * reason for dropping y -> x is the path x ~> a -> b ~> y: one of its droppable edges must be dropped as well.
+     */
+    void imply(int a, int b) {
+        vi up = ocd.reach(a, 1, REACH), down = ocd.reach(b, 0, REACH);
+        for (int x : up)
+            for (int y : down) {
+                int lit = var[y][x];
+                if (!lit || val(lit))
+                    continue;
+                vi reason{lit};
+                auto edge = [&](int u, int v) {
+                    if (var[u][v])
+                        reason.push_back(var[u][v]);
+                };
+                for (int u = x; u != a; u = ocd.via[1][u])
+                    edge(u, ocd.via[1][u]);
+                edge(a, b);
+                for (int v = y; v != b; v = ocd.via[0][v])
+                    edge(ocd.via[0][v], v);
+                reasons[lit] = {std::move(reason), 0};
+                implied.push_back(lit);
+            }
     }
 
     void notify_assignment(const vi &lits) override {
         for (const auto &lit : lits) {
-            if (lit > 0)
+            value[std::abs(lit)] = lit > 0 ? 1 : -1;
+            trail.push_back(std::abs(lit));
+        }
+        for (const auto &lit : lits) {
+            if (lit > 0 && !ordering)
                 continue;
-            if (!c.empty()) return;
-            auto [u, v] = lookup[-lit - 1];
+            auto [u, v] = lookup[std::abs(lit) - 1];
+            if (lit > 0)
+                std::swap(u, v);
+            TRACE_COUNT("maxsat.propagator.kept_edges", 1);
+            // An edge closing a cycle is left out of the graph, so the remaining edges of the batch can still yield
+            // further cycles, each with its own closing edge, which are all emitted in one go
             if (auto cycle = ocd.add_edge(u, v)) {
+                TRACE_COUNT("maxsat.propagator.cycles", 1);
+                TRACE_COUNT("maxsat.propagator.cycle_length", SZ(cycle->front()) - 1);
                 c.reserve(c.size() + cycle->size());
                 std::ranges::move(*cycle, std::back_inserter(c));
                 cycle->clear();
-                return;
+                continue;
             }
+            if (PROPAGATE)
+                imply(u, v);
         }
     }
     void notify_new_decision_level() override {
         ocd.commit();
+        levels.push_back(trail.size());
     }
     void notify_backtrack(size_t new_level) override {
+        TRACE_COUNT("maxsat.propagator.rollbacks", 1);
         ocd.rollback(new_level);
+        while (trail.size() > levels[new_level]) {
+            value[trail.back()] = 0;
+            trail.pop_back();
+        }
+        levels.resize(new_level);
+        implied.clear();
     }
     bool cb_has_external_clause(bool & is_forgettable) override {
         is_forgettable = true;
         return !c.empty();
     }
     int cb_decide() override { return 0; }
-    int cb_propagate() override { return 0; }
-    int cb_add_reason_clause_lit(int) override { return 0; }
+    int cb_propagate() override {
+        while (!implied.empty()) {
+            int lit = implied.back();
+            implied.pop_back();
+            if (val(lit) <= 0) {
+                TRACE_COUNT("maxsat.propagator.implied", 1);
+                return lit;
+            }
+        }
+        return 0;
+    }
+    int cb_add_reason_clause_lit(int lit) override {
+        auto it = reasons.find(lit);
+        if (it == reasons.end())
+            return 0;
+        // Hand out the clause from the start again if it is asked for once more
+        auto &[clause, handed] = it->second;
+        if (handed == SZ(clause)) {
+            handed = 0;
+            return 0;
+        }
+        return clause[handed++];
+    }
 
     bool cb_check_found_model(const std::vector<int> &model) override {
         return true;
@@ -257,61 +390,213 @@ class DAGPropagator : public EvalMaxSAT::ExternalPropagator {
     }
 };
 
-} // namespace
+/**
+ * @brief MaxSAT model shared by all solvers of a portfolio
+ *
+ * @details Every droppable penalty edge i -> j gets the variable e2i[i][j] with a soft clause of weight K[i][j]
+ * against dropping it; variables are numbered in row-major order, so each solver recreates the same numbering.
+ */
+struct formula {
+    int n = 0, vars = 0;
+    vvi e2i;
+    vvb adj, fixed;
+    std::vector<std::pair<std::pair<int, int>, crint>> soft;
+    vvi cycles;
+};
 
-vi exact::maxsat(const instance &inst) {
-    const cmatrix c = crossings::matrix(inst);
-    cmatrix K = penalty_graph(inst, c, true);
+// Encoding, seed and search options one solver of the portfolio runs with
+struct variant {
+    bool ordering = false;
+    uint64_t seed = 0;
+    std::vector<std::pair<const char *, int>> options;
+    bool delay = true, multi_solve = true;
+};
 
-    const int n = SZ(K);
+// Dense tables of the formula: e2i and the bit matrices
+size_t model_bytes(int n) { return size_t(n) * n * (sizeof(int) + 1); }
 
-    std::vector e2i(n, std::vector(n, -1));
-    vvb adj(n, std::vector<bool>(n));
-    vvb fixed(n, std::vector<bool>(n));
+// Dense tables of one solver: the propagator's literals, the ring buffer and the undo history of the cycle detection
+size_t solver_bytes(int n) { return size_t(n) * n * (sizeof(int) + 4 * sizeof(uint16_t)); }
 
+/**
+ * @brief Solve the model with one configuration
+ *
+ * @details Solvers sharing an incumbent publish every improved solution to it and adopt a better one before they
+ * harden soft clauses against their upper bound. The soft variables come first and are numbered alike by all
+ * solvers, so the incumbent is meaningful to each encoding.
+ * @return The dropped edges of an optimal solution, or std::nullopt if the model is unsatisfiable
+ * @throws SolveInterrupted once *stop is raised
+ */
+std::optional<vvb> run(const formula &f, const variant &v, const std::atomic<bool> *stop, SharedIncumbent *incumbent) {
+    const int n = f.n;
+    std::seed_seq seq{uint32_t(v.seed), uint32_t(n)};
+    MaLib::MonRand::seed(seq);
+    TRACE_COUNT("maxsat.ordering_encoding", v.ordering);
+    // Declared before the solver so it outlives it, the solver stays connected to it until destroyed
+    DAGPropagator propagator(f.adj, f.fixed, v.ordering);
     EvalMaxSAT solver;
-    solver.setTargetComputationTime(1800);
-    int vars = 0;
-    for (int i = 0; i < n; i++)
-        for (int j = 0; j < n; j++)
-            if (0 < K[i][j]) {
-                adj[i][j] = true;
-                fixed[i][j] = K[i][j] >= oo;
-                if (K[i][j] < oo) {
-                    e2i[i][j] = solver.newVar();
-                    ++vars;
-                    assert(e2i[i][j] == vars);
-                    solver.addClause({-e2i[i][j]}, K[i][j]);
-                }
-            }
-    DAGPropagator propagator(adj, fixed);
+    solver.setTargetComputationTime(std::min(1800.0, context::current().remaining()));
+    if (!v.delay)
+        solver.unactivateDelayStrategy();
+    if (!v.multi_solve)
+        solver.unactivateMultiSolveStrategy();
+    for (auto [name, value] : v.options)
+        solver.set_solver_option(name, value);
+    if (stop)
+        solver.set_interrupt(stop);
+    if (incumbent)
+        solver.set_shared_incumbent(incumbent);
+    for (auto [edge, weight] : f.soft) {
+        [[maybe_unused]] int x = solver.newVar();
+        assert(x == f.e2i[edge.first][edge.second]);
+        solver.addClause({-x}, weight);
+    }
     solver.connect_external_propagator(&propagator);
-    assert(vars == solver.nVars());
-    for (int v = 1; v <= vars; v++)
-        solver.add_observed_var(v);
+    assert(unsigned(f.vars) == solver.nVars());
+    for (int x = 1; x <= f.vars; x++)
+        solver.add_observed_var(x);
 
-    vvi cycles = graph::base_cycles(adj, 5000);
-    for (const auto &cycle : cycles) {
+    for (const auto &cycle : f.cycles) {
         vi clause;
         for (int i = 0; i < std::ssize(cycle); i++) {
-            int u = cycle[i], v = cycle[(i + 1) % std::ssize(cycle)];
-            if (int x = e2i[u][v]; x != -1)
+            int u = cycle[i], w = cycle[(i + 1) % std::ssize(cycle)];
+            if (int x = f.e2i[u][w]; x != -1)
                 clause.push_back(x);
         }
         solver.addClause(clause);
     }
+    if (v.ordering) {
+        // Transitivity on triangles up front, the propagator enforces it on longer cycles lazily
+        constexpr int TRIANGLES = 20000;
+        const auto &var = propagator.var;
+        auto possible = [&](int u, int w) { return f.fixed[u][w] || var[u][w]; };
+        int triangles = 0;
+        for (int i = 0; i < n && triangles < TRIANGLES; i++)
+            for (int j = i + 1; j < n && triangles < TRIANGLES; j++)
+                for (int k = j + 1; k < n && triangles < TRIANGLES; k++)
+                    for (auto [a, b, d] : {std::array{i, j, k}, std::array{i, k, j}}) {
+                        if (triangles == TRIANGLES || !possible(a, b) || !possible(b, d) || !possible(d, a))
+                            continue;
+                        vi clause;
+                        for (int x : {var[a][b], var[b][d], var[d][a]})
+                            if (x)
+                                clause.push_back(x);
+                        solver.addClause(clause);
+                        triangles++;
+                    }
+        TRACE_COUNT("maxsat.seed_triangles", triangles);
+    }
 
     if (!solver.solve())
+        return std::nullopt;
+    vvb dropped(n, std::vector<bool>(n));
+    for (auto [edge, weight] : f.soft)
+        dropped[edge.first][edge.second] = solver.getValue(f.e2i[edge.first][edge.second]);
+    return dropped;
+}
+
+} // namespace
+
+/**
+ * @brief Optimal order via MaxSAT over the droppable edges of the penalty graph
+ *
+ * @details With a portfolio size k > 1 in the context, k solvers with different encodings, seeds, CaDiCaL options and
+ * stratification settings race on the same model, each on its own thread. They share the best solution found so far,
+ * so every solver hardens against the best upper bound of the portfolio, and the first one to prove optimality
+ * interrupts the others. Fewer solvers race if the memory budget cannot hold the dense tables of all of them, and
+ * an empty order is returned if it cannot hold those of one.
+ */
+vi exact::maxsat(const instance &inst) {
+    TRACE_SCOPE("exact::maxsat");
+    // The cycle detection stores vertices in 16 bits
+    if (inst.n1 > UINT16_MAX)
         return {};
-    int64_t cost = 0, reduced_cost = 0;
+    auto model = memory_budget::acquire(2 * crossings::matrix_bytes(inst) + model_bytes(inst.n1));
+    if (!model)
+        return {};
+    const cmatrix c = crossings::matrix(inst);
+    cmatrix K = penalty_graph(inst, c, true);
+
+    formula f;
+    const int n = f.n = SZ(K);
+    f.e2i.assign(n, vi(n, -1));
+    f.adj.assign(n, std::vector<bool>(n));
+    f.fixed.assign(n, std::vector<bool>(n));
     for (int i = 0; i < n; i++)
         for (int j = 0; j < n; j++)
-            if (adj[i][j] && e2i[i][j] != -1 && solver.getValue(e2i[i][j])) {
-                adj[i][j] = false;
-                cost += c[i][j];
-                reduced_cost += K[i][j];
+            if (0 < K[i][j]) {
+                f.adj[i][j] = true;
+                f.fixed[i][j] = K[i][j] >= oo;
+                if (K[i][j] < oo) {
+                    f.e2i[i][j] = ++f.vars;
+                    f.soft.push_back({{i, j}, K[i][j]});
+                }
+            }
+    f.cycles = context::current().seeding == context::cycle_seeding::chordless ? graph::chordless_cycles(f.adj, 6, 5000)
+                                                                                : graph::base_cycles(f.adj, 5000);
+    TRACE_COUNT("maxsat.vars", f.vars);
+    TRACE_COUNT("maxsat.seed_cycles", SZ(f.cycles));
+
+    const context parent = context::current();
+    variant base;
+    base.seed = config::global().seed;
+    base.ordering = parent.encoding == context::maxsat_encoding::automatic
+                        // Reversing instead of dropping edges pays off on dense components, where most pairs are free
+                        ? 4 * int64_t(f.vars) >= int64_t(n) * (n - 1)
+                        : parent.encoding == context::maxsat_encoding::ordering;
+
+    // Every solver of the portfolio builds its own propagator, race as many as the budget allows
+    int portfolio = parent.portfolio;
+    memory_budget::lease solvers;
+    for (; portfolio > 0 && !(solvers = memory_budget::acquire(portfolio * solver_bytes(n))); portfolio--)
+        TRACE_COUNT("maxsat.portfolio.downgrades", 1);
+    if (!solvers)
+        return {};
+
+    std::optional<vvb> dropped;
+    if (portfolio <= 1) {
+        dropped = run(f, base, nullptr, nullptr);
+    } else {
+        static const std::vector<std::pair<const char *, int>> options[] = {
+            {{"stabilizeonly", 1}}, {{"phase", 0}}, {{"stabilize", 0}}, {{"elim", 0}, {"walk", 0}}};
+        std::atomic<bool> stop = false;
+        SharedIncumbent incumbent(f.vars);
+        std::mutex mutex;
+        bool done = false;
+        std::vector<std::thread> workers;
+        REP(t, 0, portfolio) workers.emplace_back([&, t] {
+            context::current() = parent;
+            variant v = base;
+            if (t > 0) {
+                v.seed += t;
+                v.ordering ^= t & 1;
+                v.options = options[(t - 1) % std::size(options)];
+                v.options.emplace_back("seed", int((base.seed + t) & 0x7fffffff));
+                v.delay = t % 3 != 1;
+                v.multi_solve = t % 3 != 2;
             }
+            try {
+                auto res = run(f, v, &stop, &incumbent);
+                std::lock_guard lock(mutex);
+                if (!done) {
+                    done = true, dropped = std::move(res);
+                    stop = true;
+                    TRACE_COUNT("maxsat.portfolio.default_wins", t == 0);
+                }
+            } catch (const SolveInterrupted &) {
+                TRACE_COUNT("maxsat.portfolio.interrupted", 1);
+            }
+        });
+        for (auto &w : workers)
+            w.join();
+    }
+    if (!dropped)
+        return {};
 
+    auto adj = f.adj;
+    for (auto [edge, weight] : f.soft)
+        if ((*dropped)[edge.first][edge.second])
+            adj[edge.first][edge.second] = false;
     auto topo = graph::topological_sort_matrix(adj);
     assert(topo.has_value());
     return *topo;
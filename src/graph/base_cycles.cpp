@@ -1,10 +1,12 @@
+#include "../common/config.hpp"
+#include "../common/trace.hpp"
 #include "graph.hpp"
 
-#include <chrono>
 #include <random>
 #include <ranges>
 
 vvi graph::base_cycles(const std::vector<std::vector<bool>> &graph, int max_cnt) {
+    TRACE_SCOPE("graph::base_cycles");
     const int n = SZ(graph);
 
     std::vector stems(n, vvi(n));
@@ -17,7 +19,7 @@ vvi graph::base_cycles(const std::vector<std::vector<bool>> &graph, int max_cnt)
             for (int k = 0; k < n; k++) {
                 if (i == k || j == k || !graph[j][k])
                     continue;
-                if (graph[k][i] && i < j && j < k)
+                if (graph[k][i] && i < j && i < k)
                     cycles.push_back({i, j, k});
                 stems[i][k].push_back(j);
             }
@@ -25,7 +27,7 @@ vvi graph::base_cycles(const std::vector<std::vector<bool>> &graph, int max_cnt)
     }
 
     if (SZ(cycles) >= max_cnt) {
-        auto rng = std::mt19937(std::chrono::steady_clock::now().time_since_epoch().count());
+        auto rng = config::global().random(n);
         std::shuffle(std::ranges::begin(cycles), std::ranges::end(cycles), rng);
         cycles.resize(max_cnt);
         return cycles;
@@ -1,161 +1,61 @@
 #include "graph.hpp"
 
-#include <functional>
-#include <unordered_map>
-#include <unordered_set>
+#include <algorithm>
+#include <numeric>
+#include <span>
 
-// Ported from
-// https://networkx.org/documentation/stable/_modules/networkx/algorithms/cycles.html#chordless_cycles
-struct nx_graph {
-    std::unordered_map<int, std::unordered_set<int>> pred, succ;
-    std::unordered_set<int> nodes;
-    void add_edge(int u, int v) {
-        pred[v].insert(u);
-        succ[u].insert(v);
-        nodes.insert(u);
-        nodes.insert(v);
-    }
-    bool has_edge(int u, int v) const { return succ.at(u).contains(v); }
-    auto build_nei() const {
-        std::unordered_map<int, std::unordered_set<int>> nei;
-        for (int u : nodes) {
-            for (int v : succ.at(u))
-                nei[u].insert(v);
-            for (int v : pred.at(u))
-                nei[u].insert(v);
-        }
-        return nei;
-    }
-    void remove_node(int v) {
-        for (int u : pred[v])
-            succ[u].erase(v);
-        for (int w : succ[v])
-            pred[w].erase(v);
-        pred.erase(v);
-        succ.erase(v);
-        nodes.erase(v);
-    }
-    nx_graph() = default;
-    explicit nx_graph(const std::vector<std::vector<bool>> &graph) {
-        int n = SZ(graph);
-        for (int i = 0; i < n; i++)
-            nodes.insert(i);
-        for (int i = 0; i < n; i++)
-            for (int j = 0; j < n; j++)
-                if (graph[i][j])
-                    add_edge(i, j);
-    }
-    auto operator[](int v) const {
-        if (!succ.contains(v))
-            return std::unordered_set<int>();
-        return succ.at(v);
-    }
-
-    std::vector<std::tuple<int, int, int, bool>> stem(int v) const {
-        std::vector<std::tuple<int, int, int, bool>> res;
-        if (!pred.contains(v) || !succ.contains(v))
-            return res;
-        for (auto u : pred.at(v))
-            for (auto w : succ.at(v))
-                if (!has_edge(u, w))
-                    res.emplace_back(u, v, w, has_edge(w, u));
-        return res;
-    }
-    nx_graph subgraph(const std::unordered_set<int> &nodes) const {
-        nx_graph res;
-        res.nodes = nodes;
-        for (int u : nodes)
-            for (int v : succ.at(u))
-                if (nodes.contains(v))
-                    res.add_edge(u, v);
-        return res;
-    }
-};
-
-std::vector<std::unordered_set<int>> nx_scc(const nx_graph &graph) {
-    std::vector<int> z;
-    std::unordered_map<int, int> comp, val;
-    int Time, ncomps;
-    std::function<int(int)> dfs = [&](int j) {
-        int low = val[j] = ++Time, x;
-        z.push_back(j);
-        for (auto e : graph[j])
-            if (!comp.contains(e))
-                low = std::min(low, val[e] ?: dfs(e));
-
-        if (low == val[j]) {
-            do {
-                x = z.back();
-                z.pop_back();
-                comp[x] = ncomps;
-            } while (x != j);
-            ncomps++;
-        }
-        return val[j] = low;
-    };
-    Time = ncomps = 0;
-    for (int i : graph.nodes)
-        if (!comp.contains(i))
-            dfs(i);
-    std::vector<std::unordered_set<int>> res(ncomps);
-    for (int i : graph.nodes)
-        res[comp[i]].insert(i);
-    return res;
-}
-
-void chordless_search(const nx_graph &graph, std::vector<int> path, int max_length,
-                      std::vector<std::vector<int>> &cycles,
-                      const std::unordered_map<int, std::unordered_set<int>> &nei) {
-    std::unordered_map<int, int> blocked;
-    int target = path.front();
-    blocked[path[1]] = 1;
-    for (int i = 1; i < std::ssize(path); i++) {
-        int w = path[i];
-        for (int v : nei.at(w))
-            blocked[v]++;
-    }
-
-    std::function<void(int)> dfs = [&](int v) {
-        for (int w : graph.succ.at(v)) {
-            if (blocked[w] == 1 && ssize(path) < max_length) {
-                if (graph.succ.at(w).contains(target)) {
-                    path.push_back(w);
-                    cycles.push_back(path);
-                    path.pop_back();
-                } else {
-                    if (nei.at(w).contains(target))
-                        continue;
-                    for (int u : nei.at(w))
-                        blocked[u]++;
-                    path.push_back(w);
-                    dfs(w);
-                    for (int u : nei.at(path.back()))
-                        blocked[u]--;
-                    path.pop_back();
-                }
-            }
-        }
-    };
-
-    dfs(path.back());
-}
-vvi triangles(const std::vector<std::vector<bool>> &graph) {
+namespace {
+vvi triangles(const std::vector<std::vector<bool>> &graph, int max_cnt) {
     int n = SZ(graph);
     vvi res;
     for (int i = 0; i < n; i++)
         for (int j = i + 1; j < n; j++)
-            for (int k = j + 1; k < n; k++)
+            for (int k = j + 1; k < n && SZ(res) < max_cnt; k++)
                 if (graph[i][j] && graph[j][k] && graph[k][i])
                     res.push_back({i, j, k});
     return res;
 }
 
-vvi graph::chordless_cycles(const std::vector<std::vector<bool>> &graph, int max_length) {
+// Successor and neighbour (successor or predecessor) lists of an induced subgraph, in local indices
+struct induced {
+    graph::csr succ, nei;
+
+    induced(const std::vector<std::vector<bool>> &graph, const vi &vertices) {
+        for (int u : vertices) {
+            REP(j, 0, SZ(vertices)) {
+                int v = vertices[j];
+                if (graph[u][v])
+                    succ.targets.push_back(j);
+                if (graph[u][v] || graph[v][u])
+                    nei.targets.push_back(j);
+            }
+            succ.offsets.push_back(SZ(succ.targets));
+            nei.offsets.push_back(SZ(nei.targets));
+        }
+    }
+};
+} // namespace
+
+/**
+ * @brief Enumerate the chordless cycles of a directed graph
+ *
+ * @param graph Adjacency matrix
+ * @param max_length Maximum number of vertices of a cycle
+ * @param max_cnt Maximum number of cycles
+ *
+ * @details Follows the networkx algorithm: in every strongly connected component of size at least 3, each stem
+ * u -> v -> w around the smallest vertex v is extended to chordless cycles through v, then v is removed and the
+ * components are recomputed. blocked[x] counts the path vertices adjacent to x, so x extends the path without a chord
+ * iff blocked[x] == 1. The search uses an explicit stack over CSR lists of the current component and the matrix for
+ * chord tests.
+ * https://networkx.org/documentation/stable/_modules/networkx/algorithms/cycles.html#chordless_cycles
+ */
+vvi graph::chordless_cycles(const std::vector<std::vector<bool>> &graph, int max_length, int max_cnt) {
     if (max_length < 3)
         return {};
     const int n = SZ(graph);
     if (max_length == 3)
-        return triangles(graph);
+        return triangles(graph, max_cnt);
     if (max_length <= 4) {
         vvi cycles;
         std::vector stems(n, vvi(n));
@@ -179,32 +79,96 @@ vvi graph::chordless_cycles(const std::vector<std::vector<bool>> &graph, int max
                     for (auto v : stems[j][i])
                         if (!graph[u][v] && !graph[v][u] && i < u && u < j && j < v)
                             cycles.push_back({i, u, j, v});
+        if (SZ(cycles) > max_cnt)
+            cycles.resize(max_cnt);
         return cycles;
     }
-    std::vector<std::vector<int>> cycles;
-    nx_graph G(graph);
-    auto sccs = nx_scc(G);
-    while (!sccs.empty()) {
-        auto scc = sccs.back();
-        sccs.pop_back();
-        if (scc.size() < 3)
+
+    vvi cycles;
+    vi blocked(n), path;
+    std::vector<std::pair<int, int>> stack;
+    vvi sets(1, vi(n));
+    std::iota(ALL(sets[0]), 0);
+    while (!sets.empty() && SZ(cycles) < max_cnt) {
+        vi vertices = std::move(sets.back());
+        sets.pop_back();
+        if (SZ(vertices) < 3)
+            continue;
+        const induced h(graph, vertices);
+        auto edge = [&](int a, int b) { return graph[vertices[a]][vertices[b]]; };
+        auto emit = [&] {
+            vi cycle(SZ(path));
+            REP(i, 0, SZ(path)) cycle[i] = vertices[path[i]];
+            cycles.push_back(std::move(cycle));
+            return SZ(cycles) >= max_cnt;
+        };
+
+        vi comp;
+        if (int ncomps = graph::scc(h.succ, comp); ncomps > 1) {
+            vvi parts(ncomps);
+            REP(i, 0, SZ(vertices)) parts[comp[i]].push_back(vertices[i]);
+            for (auto &part : parts)
+                if (SZ(part) >= 3)
+                    sets.push_back(std::move(part));
             continue;
-        nx_graph H = G.subgraph(scc);
-        auto vv = *scc.begin();
-        auto nei = H.build_nei();
-        for (auto [u, v, w, is_triangle] : H.stem(vv)) {
-            if (is_triangle) {
-                cycles.push_back({u, v, w});
+        }
+
+        // The vertices are sorted, so the root is the first one
+        const int v = 0;
+        auto neighbours = [&](const csr &g, int x) {
+            return std::span(g.targets.begin() + g.offsets[x], g.targets.begin() + g.offsets[x + 1]);
+        };
+        auto block = [&](int x, int delta) {
+            for (int y : neighbours(h.nei, x))
+                blocked[y] += delta;
+        };
+        REP(u, 0, SZ(vertices)) {
+            if (!edge(u, v))
                 continue;
+            for (int w : neighbours(h.succ, v)) {
+                if (u == w || edge(u, w))
+                    continue;
+                path = {u, v, w};
+                if (edge(w, u)) {
+                    if (emit())
+                        return cycles;
+                    continue;
+                }
+                std::fill_n(blocked.begin(), SZ(vertices), 0);
+                blocked[v] = 1;
+                block(v, 1);
+                block(w, 1);
+                stack.assign(1, {w, 0});
+                while (!stack.empty()) {
+                    auto [x, e] = stack.back();
+                    auto out = neighbours(h.succ, x);
+                    if (e == SZ(out)) {
+                        stack.pop_back();
+                        if (!stack.empty())
+                            block(x, -1), path.pop_back();
+                        continue;
+                    }
+                    stack.back().second++;
+                    int y = out[e];
+                    if (blocked[y] != 1 || SZ(path) >= max_length)
+                        continue;
+                    if (edge(y, u)) {
+                        path.push_back(y);
+                        if (emit())
+                            return cycles;
+                        path.pop_back();
+                        continue;
+                    }
+                    if (edge(u, y))
+                        continue;
+                    block(y, 1);
+                    path.push_back(y);
+                    stack.emplace_back(y, 0);
+                }
             }
-
-            chordless_search(H, {u, v, w}, max_length, cycles, nei);
         }
-        H.remove_node(vv);
-        auto new_sccs = nx_scc(H);
-        for (const auto &new_scc : new_sccs)
-            if (new_scc.size() > 2)
-                sccs.push_back(new_scc);
+        vertices.erase(vertices.begin());
+        sets.push_back(std::move(vertices));
     }
     return cycles;
 }
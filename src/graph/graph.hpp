@@ -1,17 +1,31 @@
 #pragma once
 
+#include "../common/cmatrix.hpp"
 #include "../common/instance.hpp"
 #include "../common/macros.hpp"
 #include <cassert>
 #include <optional>
 
 struct graph {
-    static vvi chordless_cycles(const std::vector<std::vector<bool>> &graph, int max_length = 1e9);
+    // Compressed sparse rows: the successors of v are targets[offsets[v]], ..., targets[offsets[v + 1] - 1]
+    struct csr {
+        vi offsets{0}, targets;
+        csr() = default;
+        explicit csr(const vvi &adj);
+        [[nodiscard]] int size() const { return SZ(offsets) - 1; }
+        [[nodiscard]] csr transpose() const;
+    };
+
+    static vvi chordless_cycles(const std::vector<std::vector<bool>> &graph, int max_length = 1e9, int max_cnt = 1e9);
     static vvi base_cycles(const std::vector<std::vector<bool>> &graph, int max_cnt = 1e9);
+    static int scc(const csr &graph, vi &comp);
     static int scc(const vvi &graph, vi &comp);
+    static int parallel_scc(const csr &graph, vi &comp, int threads);
+    static int sorted_scc(const csr &graph, vi &comp, int threads = 1);
     static int sorted_scc(const vvi &graph, vi &comp);
     static std::optional<vi> topological_sort(const vvi &graph);
-    template <class T> static std::optional<vi> topological_sort_matrix(const std::vector<std::vector<T>> &graph);
+    template <class M> static std::optional<vi> topological_sort_matrix(const M &graph);
     static int pathwidth(const instance &inst);
-    template <class T> static vvi matrix_to_list(const std::vector<std::vector<T>> &matrix);
+    static int cutwidth(const instance &inst);
+    template <class M> static vvi matrix_to_list(const M &matrix);
 };
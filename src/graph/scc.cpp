@@ -1,47 +1,202 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <numeric>
+#include <thread>
 #include <vector>
 
 #include "../common/macros.hpp"
 #include "graph.hpp"
 
-int graph::scc(const vvi &adj, vi &comp) {
-    vi val, z;
-    int Time, ncomps;
-    std::function<int(int)> dfs = [&](int j) {
-        int low = val[j] = ++Time, x;
-        z.push_back(j);
-        for (auto e : adj[j])
-            if (comp[e] < 0)
-                low = std::min(low, val[e] ?: dfs(e));
-
-        if (low == val[j]) {
-            do {
-                x = z.back();
-                z.pop_back();
-                comp[x] = ncomps;
-            } while (x != j);
-            ncomps++;
-        }
-        return val[j] = low;
+graph::csr::csr(const vvi &adj) {
+    offsets.assign(SZ(adj) + 1, 0);
+    REP(i, 0, SZ(adj)) offsets[i + 1] = offsets[i] + SZ(adj[i]);
+    targets.reserve(offsets.back());
+    for (const auto &row : adj)
+        targets.insert(targets.end(), ALL(row));
+}
+
+graph::csr graph::csr::transpose() const {
+    csr res;
+    res.offsets.assign(size() + 1, 0);
+    for (int v : targets)
+        res.offsets[v + 1]++;
+    REP(i, 0, size()) res.offsets[i + 1] += res.offsets[i];
+    res.targets.resize(targets.size());
+    vi pos(res.offsets.begin(), res.offsets.end() - 1);
+    REP(u, 0, size()) REP(e, offsets[u], offsets[u + 1]) res.targets[pos[targets[e]]++] = u;
+    return res;
+}
+
+namespace {
+/**
+ * @brief Iterative Tarjan restricted to the vertices accepted by keep
+ *
+ * @details Components are numbered from 0 in reverse topological order. val and low are indexed by vertex and val
+ * must be zero on the visited vertices, so disjoint vertex sets may share them across threads. stack, call and edge
+ * are scratch buffers with room for all vertices of the set.
+ */
+template <class Keep>
+int tarjan(const graph::csr &g, const vi &vertices, Keep keep, vi &comp, vi &val, vi &low, vi &stack, vi &call,
+           vi &edge) {
+    int time = 0, ncomps = 0, sp = 0, cp = 0;
+    auto visit = [&](int v) {
+        val[v] = low[v] = ++time;
+        stack[sp++] = v;
+        call[cp] = v;
+        edge[cp++] = g.offsets[v];
     };
-    int n = SZ(adj);
-    val.assign(n, 0);
+    for (int s : vertices) {
+        if (val[s])
+            continue;
+        visit(s);
+        while (cp) {
+            int v = call[cp - 1];
+            if (edge[cp - 1] < g.offsets[v + 1]) {
+                int w = g.targets[edge[cp - 1]++];
+                if (!keep(w))
+                    continue;
+                if (!val[w])
+                    visit(w);
+                else if (comp[w] < 0)
+                    low[v] = std::min(low[v], val[w]);
+                continue;
+            }
+            cp--;
+            if (low[v] == val[v]) {
+                int x;
+                do {
+                    x = stack[--sp];
+                    comp[x] = ncomps;
+                } while (x != v);
+                ncomps++;
+            }
+            if (cp)
+                low[call[cp - 1]] = std::min(low[call[cp - 1]], low[v]);
+        }
+    }
+    return ncomps;
+}
+} // namespace
+
+int graph::scc(const csr &g, vi &comp) {
+    int n = g.size();
+    vi vertices(n), val(n), low(n), stack(n), call(n), edge(n);
+    std::iota(ALL(vertices), 0);
     comp.assign(n, -1);
-    Time = ncomps = 0;
-    for (int i = 0; i < n; i++)
-        if (comp[i] < 0)
-            dfs(i);
+    return tarjan(g, vertices, [](int) { return true; }, comp, val, low, stack, call, edge);
+}
+
+int graph::scc(const vvi &adj, vi &comp) { return scc(csr(adj), comp); }
+
+/**
+ * @brief Forward-backward strongly connected components
+ *
+ * @details Every task owns a colour class: the vertices reachable from a pivot both forwards and backwards form its
+ * component, and the forward-only, backward-only and remaining vertices become three new tasks. Classes below a size
+ * threshold are finished with Tarjan. Component ids are not topologically sorted.
+ */
+int graph::parallel_scc(const csr &g, vi &comp, int threads) {
+    constexpr int SEQUENTIAL = 1 << 12;
+    int n = g.size();
+    if (threads <= 1 || n <= SEQUENTIAL)
+        return scc(g, comp);
+    const csr r = g.transpose();
+    comp.assign(n, -1);
+    std::vector<std::atomic<int>> color(n);
+    vi val(n), low(n);
+    std::vector<char> mark(n);
+    std::atomic<int> ncomps = 0, colors = 1;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<std::pair<int, vi>> tasks;
+    int pending = 1;
+    tasks.emplace_back(0, vi(n));
+    std::iota(ALL(tasks.back().second), 0);
+
+    auto reach = [&](const csr &h, int pivot, int c, char bit) {
+        vi queue{pivot};
+        mark[pivot] |= bit;
+        REP(i, 0, SZ(queue)) REP(e, h.offsets[queue[i]], h.offsets[queue[i] + 1]) {
+            int w = h.targets[e];
+            if (color[w].load(std::memory_order_relaxed) == c && !(mark[w] & bit))
+                mark[w] |= bit, queue.push_back(w);
+        }
+    };
+    auto process = [&](int c, vi vertices) {
+        if (SZ(vertices) <= SEQUENTIAL) {
+            auto keep = [&](int w) { return color[w].load(std::memory_order_relaxed) == c; };
+            vi stack(SZ(vertices)), call(SZ(vertices)), edge(SZ(vertices));
+            int k = tarjan(g, vertices, keep, comp, val, low, stack, call, edge);
+            int base = ncomps.fetch_add(k);
+            for (int v : vertices)
+                comp[v] += base;
+            return std::vector<std::pair<int, vi>>();
+        }
+        reach(g, vertices[0], c, 1);
+        reach(r, vertices[0], c, 2);
+        int id = ncomps++;
+        std::array<vi, 3> parts;
+        for (int v : vertices) {
+            if (mark[v] == 3)
+                comp[v] = id;
+            else
+                parts[mark[v]].push_back(v);
+        }
+        std::vector<std::pair<int, vi>> next;
+        for (auto &part : parts) {
+            if (part.empty())
+                continue;
+            int d = colors++;
+            for (int v : part)
+                color[v].store(d, std::memory_order_relaxed), mark[v] = 0;
+            next.emplace_back(d, std::move(part));
+        }
+        return next;
+    };
+
+    auto worker = [&] {
+        std::unique_lock lock(mutex);
+        while (true) {
+            cv.wait(lock, [&] { return !tasks.empty() || !pending; });
+            if (!pending)
+                return;
+            auto [c, vertices] = std::move(tasks.back());
+            tasks.pop_back();
+            lock.unlock();
+            auto next = process(c, std::move(vertices));
+            lock.lock();
+            pending += SZ(next) - 1;
+            for (auto &task : next)
+                tasks.push_back(std::move(task));
+            cv.notify_all();
+        }
+    };
+    std::vector<std::thread> workers;
+    REP(i, 0, threads) workers.emplace_back(worker);
+    for (auto &t : workers)
+        t.join();
     return ncomps;
 }
 
-int graph::sorted_scc(const std::vector<std::vector<int>> &adj, vi &comp) {
-    int n = SZ(adj);
-    vi res;
-    int ncomps = scc(adj, res);
-    std::vector<std::vector<int>> condensation(ncomps);
-    for (int i = 0; i < n; i++)
-        for (auto e : adj[i])
-            if (res[i] != res[e])
-                condensation[res[i]].push_back(res[e]);
+int graph::sorted_scc(const csr &g, vi &comp, int threads) {
+    int n = g.size();
+    vi res, label;
+    int ncomps = parallel_scc(g, res, threads);
+    // Number the components by their smallest vertex, so the order below depends on neither the thread count nor
+    // thread timing
+    label.assign(ncomps, -1);
+    for (int i = 0, next = 0; i < n; i++)
+        if (label[res[i]] < 0)
+            label[res[i]] = next++;
+    for (int &c : res)
+        c = label[c];
+    vvi condensation(ncomps);
+    REP(i, 0, n) REP(e, g.offsets[i], g.offsets[i + 1]) if (res[i] != res[g.targets[e]])
+        condensation[res[i]].push_back(res[g.targets[e]]);
     auto topo = *graph::topological_sort(condensation);
     vi inv(ncomps);
     for (int i = 0; i < ncomps; i++)
@@ -51,3 +206,5 @@ int graph::sorted_scc(const std::vector<std::vector<int>> &adj, vi &comp) {
         comp[i] = inv[res[i]];
     return ncomps;
 }
+
+int graph::sorted_scc(const vvi &adj, vi &comp) { return sorted_scc(csr(adj), comp); }
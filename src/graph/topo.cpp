@@ -26,12 +26,12 @@ std::optional<vi> graph::topological_sort(const vvi &adj) {
 template std::optional<vi> graph::topological_sort_matrix(const cmatrix &matrix);
 template std::optional<vi> graph::topological_sort_matrix(const std::vector<std::vector<bool>> &matrix);
 
-template <class T> std::optional<vi> graph::topological_sort_matrix(const std::vector<std::vector<T>> &adj) {
+template <class M> std::optional<vi> graph::topological_sort_matrix(const M &adj) {
     int n = SZ(adj), i = 0;
     vi in(n), topo(n, -1);
-    for (const auto &row : adj)
+    for (int k = 0; k < n; k++)
         for (int j = 0; j < n; j++)
-            in[j] += !!row[j];
+            in[j] += !!adj[k][j];
     for (int j = 0; j < n; j++)
         if (!in[j])
             topo[i++] = j;
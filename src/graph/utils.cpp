@@ -8,7 +8,7 @@
 template vvi graph::matrix_to_list(const cmatrix &matrix);
 template vvi graph::matrix_to_list(const std::vector<std::vector<bool>> &matrix);
 
-template <class T> vvi graph::matrix_to_list(const std::vector<std::vector<T>> &matrix) {
+template <class M> vvi graph::matrix_to_list(const M &matrix) {
     int n = SZ(matrix);
     vvi adj(n);
     for (int i = 0; i < n; i++)
@@ -30,3 +30,26 @@ int graph::pathwidth(const instance &inst) {
     std::partial_sum(ALL(depth), depth.begin());
     return *std::ranges::max_element(depth);
 }
+
+/**
+ * @brief Cutwidth of the layout given with the instance
+ *
+ * @return The cutwidth, or -1 if the instance has no layout or the layout does not keep the left vertices in their
+ * fixed order. Otherwise every right vertex spanning the gap between two consecutive left vertices has an edge across
+ * the corresponding cut, hence pathwidth(inst) <= cutwidth(inst).
+ */
+int graph::cutwidth(const instance &inst) {
+    if (SZ(inst.order) != inst.n0 + inst.n1)
+        return -1;
+    vi position(inst.n0 + inst.n1);
+    REP(i, 0, SZ(inst.order)) position[inst.order[i]] = i;
+    REP(x, 1, inst.n0) if (position[x - 1] > position[x]) return -1;
+    vi cut(inst.n0 + inst.n1 + 1);
+    REP(y, 0, inst.n1) for (int x : inst.neighbors[y]) {
+        auto [l, r] = std::minmax(position[x], position[inst.n0 + y]);
+        cut[l]++;
+        cut[r]--;
+    }
+    std::partial_sum(ALL(cut), cut.begin());
+    return *std::ranges::max_element(cut);
+}
@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <chrono>
 
+#include "../common/cmatrix.hpp"
 #include "../common/instance.hpp"
 #include "../common/macros.hpp"
 
@@ -11,4 +12,9 @@ struct heuristic {
     static vi barycenter(const instance &inst);
     static vi median(const instance &inst);
     static vi quick(const instance &inst);
+    static vi block_switch(const vvi &block);
+    static vi multilevel(const instance &inst);
+    static vi anneal(const instance &inst, vi p, double seconds);
+    static vi tabu(const instance &inst, vi p, double seconds);
+    static void streaming(std::istream &is, std::ostream &os, size_t budget);
 };
@@ -0,0 +1,187 @@
+#include <chrono>
+#include <cmath>
+#include <random>
+
+#include "../common/config.hpp"
+#include "../common/crossings.hpp"
+#include "../common/memory_budget.hpp"
+#include "../common/trace.hpp"
+#include "heuristic.hpp"
+
+namespace {
+using clock = std::chrono::steady_clock;
+
+// Largest distance an insertion moves a vertex, adjacent swaps are insertions over distance 1
+constexpr int RADIUS = 16;
+// Steps of crossings::matrix per second, between 4e8 and 1e9 on heuristic-public
+constexpr double MATRIX_RATE = 5e8;
+
+/**
+ * @brief Change in crossings when the vertex at position i is moved to position j
+ *
+ * @details Complexity: O(|i - j|), O(1) for an adjacent swap
+ * Only the pairs formed with the vertices it jumps over change their relative order.
+ */
+template <class View> crint shift_delta(const View &C, const vi &p, int i, int j) {
+    crint d = 0;
+    int v = p[i];
+    for (int k = i + 1; k <= j; k++)
+        d += crint(C[p[k]][v]) - crint(C[v][p[k]]);
+    for (int k = j; k < i; k++)
+        d += crint(C[v][p[k]]) - crint(C[p[k]][v]);
+    return d;
+}
+
+void shift(vi &p, int i, int j) {
+    if (i < j)
+        std::rotate(p.begin() + i, p.begin() + i + 1, p.begin() + j + 1);
+    else
+        std::rotate(p.begin() + j, p.begin() + i, p.begin() + i + 1);
+}
+
+double elapsed(clock::time_point start) { return std::chrono::duration<double>(clock::now() - start).count(); }
+
+/**
+ * @brief Lease for the crossing matrix of the search
+ *
+ * @details The lease is empty if the matrix does not fit the memory budget, or if building it, n1 * (n0 + n1 + m)
+ * steps, would already take the whole time budget.
+ */
+memory_budget::lease lease_matrix(const instance &inst, double seconds) {
+    double steps = inst.n0 + inst.n1;
+    for (const auto &adj : inst.neighbors)
+        steps += SZ(adj);
+    if (steps * inst.n1 / MATRIX_RATE >= seconds) {
+        TRACE_COUNT("heuristic::metaheuristic.out_of_time", 1);
+        return {};
+    }
+    return memory_budget::acquire(crossings::matrix_bytes(inst));
+}
+} // namespace
+
+/**
+ * @brief Simulated annealing over insertion moves
+ *
+ * @param p The initial order, e.g. from quick
+ * @param seconds Time budget, including the crossing matrix
+ * @return The best order seen, with at most as many crossings as p, or p itself if the crossing matrix does not fit
+ * the memory or the time budget
+ *
+ * @details Complexity: O(n1^2 + m) setup, O(1) per adjacent swap and O(RADIUS) per insertion
+ * Half of the moves are adjacent swaps, the others move a vertex by up to RADIUS positions. The temperature starts at
+ * the mean gain of an adjacent swap and cools geometrically to a thousandth of it over the time budget.
+ */
+vi heuristic::anneal(const instance &inst, vi p, double seconds) {
+    TRACE_SCOPE("heuristic::anneal");
+    const int n = SZ(p);
+    if (n < 2)
+        return p;
+    const auto start = clock::now();
+    auto lease = lease_matrix(inst, seconds);
+    if (!lease)
+        return p;
+    const cmatrix matrix = crossings::matrix(inst);
+    auto rng = config::global().random(n);
+    return matrix.visit([&](auto C) {
+        double t0 = 0;
+        REP(i, 0, n - 1) t0 += std::abs(double(C[p[i]][p[i + 1]]) - double(C[p[i + 1]][p[i]]));
+        t0 = std::max(t0 / (n - 1), 1.0);
+        double t = t0;
+        std::uniform_real_distribution<double> unit(0, 1);
+        crint cur = 0, best = 0;
+        vi best_p = p;
+        long long moves = 0, accepted = 0;
+        for (;; moves++) {
+            if (!(moves & 1023)) {
+                double progress = elapsed(start) / seconds;
+                if (progress >= 1)
+                    break;
+                t = t0 * std::pow(1e-3, progress);
+            }
+            int i = int(rng() % n), j;
+            if (rng() & 1)
+                j = i + 1 < n ? i + 1 : i - 1;
+            else
+                j = std::clamp(i + int(rng() % (2 * RADIUS + 1)) - RADIUS, 0, n - 1);
+            if (i == j)
+                continue;
+            crint d = shift_delta(C, p, i, j);
+            if (d > 0 && unit(rng) >= std::exp(-double(d) / t))
+                continue;
+            shift(p, i, j);
+            cur += d, accepted++;
+            if (cur < best)
+                best = cur, best_p = p;
+        }
+        TRACE_COUNT("heuristic::anneal.moves", moves);
+        TRACE_COUNT("heuristic::anneal.accepted", accepted);
+        TRACE_COUNT("heuristic::anneal.moves_per_second", (long long)(moves / std::max(elapsed(start), 1e-9)));
+        return best_p;
+    });
+}
+
+/**
+ * @brief Tabu search over insertion moves
+ *
+ * @param p The initial order, e.g. from quick
+ * @param seconds Time budget, including the crossing matrix
+ * @return The best order seen, with at most as many crossings as p, or p itself if the crossing matrix does not fit
+ * the memory or the time budget
+ *
+ * @details Complexity: O(n1^2 + m) setup, O(RADIUS) per move
+ * Every step picks a random vertex and makes its best insertion within RADIUS positions, even if it is worsening.
+ * The vertex is then tabu for a tenure drawn around sqrt(n1) steps, unless a move of it reaches a new best order.
+ */
+vi heuristic::tabu(const instance &inst, vi p, double seconds) {
+    TRACE_SCOPE("heuristic::tabu");
+    const int n = SZ(p);
+    if (n < 2)
+        return p;
+    const auto start = clock::now();
+    auto lease = lease_matrix(inst, seconds);
+    if (!lease)
+        return p;
+    const cmatrix matrix = crossings::matrix(inst);
+    auto rng = config::global().random(n);
+    const int tenure = std::max(2, int(std::sqrt(n)));
+    return matrix.visit([&](auto C) {
+        crint cur = 0, best = 0;
+        vi best_p = p;
+        std::vector<long long> until(n);
+        long long moves = 0, blocked = 0;
+        for (;; moves++) {
+            if (!(moves & 255) && elapsed(start) >= seconds)
+                break;
+            int i = int(rng() % n), v = p[i];
+            // Sweep the targets outwards so that each delta extends the previous one in O(1)
+            crint d_best = oo, d = 0;
+            int j_best = i;
+            for (int j = i + 1; j < std::min(n, i + RADIUS + 1); j++) {
+                d += crint(C[p[j]][v]) - crint(C[v][p[j]]);
+                if (d < d_best)
+                    d_best = d, j_best = j;
+            }
+            d = 0;
+            for (int j = i - 1; j >= std::max(0, i - RADIUS); j--) {
+                d += crint(C[v][p[j]]) - crint(C[p[j]][v]);
+                if (d < d_best)
+                    d_best = d, j_best = j;
+            }
+            if (j_best == i)
+                continue;
+            if (until[v] > moves && cur + d_best >= best) {
+                blocked++;
+                continue;
+            }
+            shift(p, i, j_best);
+            cur += d_best;
+            until[v] = moves + tenure + int(rng() % tenure);
+            if (cur < best)
+                best = cur, best_p = p;
+        }
+        TRACE_COUNT("heuristic::tabu.moves", moves);
+        TRACE_COUNT("heuristic::tabu.blocked", blocked);
+        TRACE_COUNT("heuristic::tabu.moves_per_second", (long long)(moves / std::max(elapsed(start), 1e-9)));
+        return best_p;
+    });
+}
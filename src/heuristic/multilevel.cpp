@@ -0,0 +1,111 @@
+#include <algorithm>
+#include <map>
+#include <numeric>
+
+#include "../common/crossings.hpp"
+#include "../common/trace.hpp"
+#include "heuristic.hpp"
+
+namespace {
+// Levels at most this large are solved directly
+constexpr int COARSEST = 1024;
+// Window of the refinement, consecutive windows overlap by half
+constexpr int WINDOW = 32;
+constexpr int PASSES = 4;
+
+/**
+ * @brief Group the right vertices of the next coarser level
+ *
+ * @details Twins are merged first, as in reduction::merge_twins. If that leaves more than 60% of the vertices,
+ * consecutive twin classes of the barycenter order are paired up instead, which approximates merging vertices with
+ * similar neighbourhoods.
+ */
+vvi coarsen(const instance &inst, const std::vector<double> &barycenter) {
+    std::map<vi, vi> twins;
+    REP(v, 0, inst.n1) twins[inst.neighbors[v]].push_back(v);
+    vvi groups;
+    groups.reserve(SZ(twins));
+    for (auto &[neighbors, vertices] : twins)
+        groups.push_back(std::move(vertices));
+    if (SZ(groups) * 5 <= inst.n1 * 3)
+        return groups;
+    std::ranges::stable_sort(groups, {}, [&](const vi &g) { return barycenter[g[0]]; });
+    vvi paired;
+    paired.reserve((SZ(groups) + 1) / 2);
+    for (int i = 0; i < SZ(groups); i += 2) {
+        paired.push_back(std::move(groups[i]));
+        if (i + 1 < SZ(groups))
+            paired.back().insert(paired.back().end(), ALL(groups[i + 1]));
+    }
+    return paired;
+}
+
+// The instance with one right vertex per group, adjacent to the multiset union of the group's neighbourhoods
+instance contract(const instance &inst, const vvi &groups) {
+    instance res(inst.n0, SZ(groups));
+    REP(g, 0, SZ(groups)) {
+        for (int v : groups[g])
+            res.neighbors[g].insert(res.neighbors[g].end(), ALL(inst.neighbors[v]));
+        std::ranges::sort(res.neighbors[g]);
+        for (int u : res.neighbors[g])
+            res.back_neighbors[u].push_back(g);
+    }
+    return res;
+}
+
+// Improve p window by window with greedy_switch, for a few passes or until a pass changes nothing
+void refine(const instance &inst, vi &p) {
+    for (int pass = 0; pass < PASSES; pass++) {
+        vi before = p;
+        for (int start = 0; start < SZ(p); start += WINDOW / 2) {
+            int end = std::min(SZ(p), start + WINDOW);
+            vvi block;
+            REP(i, start, end) block.push_back(inst.neighbors[p[i]]);
+            vi q = heuristic::block_switch(block), window;
+            for (int i : q)
+                window.push_back(p[start + i]);
+            std::ranges::copy(window, p.begin() + start);
+            if (end == SZ(p))
+                break;
+        }
+        if (p == before)
+            break;
+    }
+}
+} // namespace
+
+/**
+ * @brief Multilevel heuristic for large instances
+ *
+ * @details Complexity: O((m log n1 + n1 * WINDOW^2) * levels) time, O(n0 + n1 + m) memory per level
+ * Right vertices with similar neighbourhoods are merged level by level, which leaves at most 60% of the vertices of
+ * every level (twin classes stop at that, pairing halves), until at most COARSEST remain. These are ordered by quick
+ * and greedy_switch. Every level then expands the order of the next coarser one, placing the members of a group by
+ * barycenter, or takes the order of quick if that crosses less, and refines it with overlapping greedy_switch windows.
+ * The result never crosses more than quick.
+ */
+vi heuristic::multilevel(const instance &inst) {
+    TRACE_SCOPE("heuristic::multilevel");
+    if (inst.n1 <= COARSEST) {
+        vi p = quick(inst);
+        greedy_switch(p, crossings::matrix(inst));
+        refine(inst, p);
+        return p;
+    }
+    std::vector<double> barycenter(inst.n1);
+    REP(v, 0, inst.n1) if (!inst.neighbors[v].empty()) barycenter[v] =
+        std::accumulate(ALL(inst.neighbors[v]), 0.0) / SZ(inst.neighbors[v]);
+    vvi groups = coarsen(inst, barycenter);
+    TRACE_COUNT("heuristic::multilevel.levels", 1);
+    vi coarse = multilevel(contract(inst, groups)), p;
+    p.reserve(inst.n1);
+    for (int g : coarse) {
+        std::ranges::stable_sort(groups[g], {}, [&](int v) { return barycenter[v]; });
+        p.insert(p.end(), ALL(groups[g]));
+    }
+    // Merging dissimilar groups can cost more than the refinement wins back, start from quick if it is already better
+    if (vi q = quick(inst); crossings::count(inst, q) < crossings::count(inst, p))
+        p = std::move(q);
+    refine(inst, p);
+    return p;
+}
@@ -1,7 +1,9 @@
 #include "../common/crossings.hpp"
+#include "../common/trace.hpp"
 #include "heuristic.hpp"
 
 vi heuristic::quick(const instance &inst) {
+    TRACE_SCOPE("heuristic::quick");
     auto barycenter = heuristic::barycenter(inst);
     auto median = heuristic::median(inst);
     std::vector solutions = {barycenter, median};
@@ -0,0 +1,224 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <numeric>
+#include <queue>
+#include <sstream>
+
+#include "../common/crossings.hpp"
+#include "../common/trace.hpp"
+#include "heuristic.hpp"
+
+namespace {
+struct edge {
+    uint32_t key, u;
+    auto operator<=>(const edge &) const = default;
+};
+
+using file = std::unique_ptr<std::FILE, decltype(&std::fclose)>;
+
+file temporary() {
+    file f(std::tmpfile(), &std::fclose);
+    if (!f)
+        throw std::runtime_error("Could not create temporary file");
+    return f;
+}
+
+struct reader {
+    std::FILE *f;
+    std::vector<edge> buffer;
+    size_t pos = 0, len = 0;
+    reader(std::FILE *f, size_t capacity) : f(f), buffer(std::max<size_t>(capacity, 1)) {}
+    bool next(edge &e) {
+        if (pos == len) {
+            len = std::fread(buffer.data(), sizeof(edge), buffer.size(), f);
+            pos = 0;
+            if (!len)
+                return false;
+        }
+        e = buffer[pos++];
+        return true;
+    }
+};
+
+/**
+ * @brief Sort the edges of a file by (key, u) using at most budget bytes
+ *
+ * @details Complexity: O(m log m) time, O(m) disk space
+ * Sorted runs of budget bytes are written to temporary files and merged with one read buffer per run.
+ */
+file external_sort(std::FILE *in, size_t budget) {
+    const size_t chunk = std::max<size_t>(budget / sizeof(edge), 1);
+    std::vector<file> runs;
+    {
+        std::vector<edge> buffer(chunk);
+        std::rewind(in);
+        while (size_t len = std::fread(buffer.data(), sizeof(edge), chunk, in)) {
+            std::sort(buffer.begin(), buffer.begin() + static_cast<long>(len));
+            auto &run = runs.emplace_back(temporary());
+            std::fwrite(buffer.data(), sizeof(edge), len, run.get());
+            std::rewind(run.get());
+        }
+    }
+    file out = temporary();
+    std::vector<reader> readers;
+    readers.reserve(runs.size());
+    for (auto &run : runs)
+        readers.emplace_back(run.get(), chunk / (runs.size() + 1));
+    std::vector<edge> buffer;
+    buffer.reserve(chunk / (runs.size() + 1) + 1);
+    using item = std::pair<edge, int>;
+    std::priority_queue<item, std::vector<item>, std::greater<>> pq;
+    REP(i, 0, SZ(readers)) if (edge e; readers[i].next(e)) pq.emplace(e, i);
+    while (!pq.empty()) {
+        auto [e, i] = pq.top();
+        pq.pop();
+        buffer.push_back(e);
+        if (buffer.size() == buffer.capacity())
+            std::fwrite(buffer.data(), sizeof(edge), buffer.size(), out.get()), buffer.clear();
+        if (readers[i].next(e))
+            pq.emplace(e, i);
+    }
+    std::fwrite(buffer.data(), sizeof(edge), buffer.size(), out.get());
+    std::rewind(out.get());
+    return out;
+}
+} // namespace
+
+vi heuristic::block_switch(const vvi &block) {
+    vi left;
+    for (const auto &adj : block)
+        left.insert(left.end(), ALL(adj));
+    std::ranges::sort(left);
+    left.erase(std::unique(ALL(left)), left.end());
+    instance inst(SZ(left), SZ(block));
+    REP(v, 0, SZ(block)) {
+        for (int u : block[v]) {
+            int x = int(std::ranges::lower_bound(left, u) - left.begin());
+            inst.neighbors[v].push_back(x);
+            inst.back_neighbors[x].push_back(v);
+        }
+    }
+    vi p(SZ(block));
+    std::iota(ALL(p), 0);
+    greedy_switch(p, crossings::matrix(inst));
+    return p;
+}
+
+/**
+ * @brief Stream an instance from is and write a barycenter order refined by windowed local search to os
+ *
+ * @param budget Memory budget in bytes for the edge buffers and the local search window, main passes what is left
+ * of the process-wide memory_budget
+ *
+ * @details Complexity: O(m log m + n1 * window) time, O(n0 + n1) memory plus the budget
+ * The barycenters are accumulated in a single pass over the edge stream, which is spilled to disk. The spilled edges
+ * are then externally sorted by the barycenter rank of their right vertex, so that a window of consecutive right
+ * vertices can be read with its adjacency lists and improved by greedy_switch. The first half of every window is
+ * final, the second half is carried over into the next window.
+ */
+void heuristic::streaming(std::istream &is, std::ostream &os, size_t budget) {
+    TRACE_SCOPE("heuristic::streaming");
+    while (is.peek() != 'p' && is.peek() != std::char_traits<char>::eof())
+        is.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    std::string ocr_line;
+    std::getline(is, ocr_line);
+    std::stringstream ss(ocr_line);
+    char p;
+    std::string ocr;
+    long long n0, n1, m;
+    ss >> p >> ocr >> n0 >> n1 >> m;
+    if (p != 'p' || ocr != "ocr")
+        throw std::invalid_argument("Invalid instance format");
+    int cutwidth;
+    ss >> cutwidth;
+    if (!ss.fail())
+        REP(i, 0, n0 + n1) {
+            int x;
+            is >> x;
+        }
+
+    // The edge buffers never need to hold more than all edges, however large the budget
+    const size_t buffers = std::min<size_t>(budget, 4 * std::max(m, 1ll) * sizeof(edge));
+    std::vector<double> barycenter(n1);
+    std::vector<int> degree(n1);
+    file edges = temporary();
+    {
+        std::vector<edge> buffer;
+        buffer.reserve(std::max<size_t>(buffers / 2 / sizeof(edge), 1));
+        REP(i, 0, m) {
+            uint32_t u, v;
+            is >> u >> v;
+            v -= static_cast<uint32_t>(n0 + 1);
+            barycenter[v] += u - 1;
+            degree[v]++;
+            buffer.push_back({v, u - 1});
+            if (buffer.size() == buffer.capacity())
+                std::fwrite(buffer.data(), sizeof(edge), buffer.size(), edges.get()), buffer.clear();
+        }
+        std::fwrite(buffer.data(), sizeof(edge), buffer.size(), edges.get());
+    }
+    REP(v, 0, n1) if (degree[v]) barycenter[v] /= degree[v];
+
+    vi order(n1), rank(n1);
+    std::iota(ALL(order), 0);
+    std::ranges::stable_sort(order, {}, [&](int v) { return barycenter[v]; });
+    REP(i, 0, n1) rank[order[i]] = i;
+    barycenter = {};
+    degree = {};
+
+    {
+        std::rewind(edges.get());
+        reader in(edges.get(), buffers / 4 / sizeof(edge));
+        file ranked = temporary();
+        std::vector<edge> buffer;
+        buffer.reserve(std::max<size_t>(buffers / 4 / sizeof(edge), 1));
+        for (edge e; in.next(e);) {
+            buffer.push_back({static_cast<uint32_t>(rank[e.key]), e.u});
+            if (buffer.size() == buffer.capacity())
+                std::fwrite(buffer.data(), sizeof(edge), buffer.size(), ranked.get()), buffer.clear();
+        }
+        std::fwrite(buffer.data(), sizeof(edge), buffer.size(), ranked.get());
+        edges = std::move(ranked);
+    }
+    rank = {};
+    edges = external_sort(edges.get(), buffers / 2);
+
+    const int window = static_cast<int>(std::clamp<size_t>(std::sqrt(budget / 4 / sizeof(crint)), 2, 256));
+    const size_t max_edges = std::max<size_t>(budget / 4 / sizeof(int), 1);
+    reader in(edges.get(), buffers / 4 / sizeof(edge));
+    vi vertices;
+    vvi block;
+    size_t block_edges = 0;
+    auto flush = [&](size_t keep) {
+        vi q = block_switch(block);
+        vi new_vertices;
+        vvi new_block;
+        for (int i : q) {
+            new_vertices.push_back(vertices[i]);
+            new_block.push_back(std::move(block[i]));
+        }
+        size_t emit = new_vertices.size() - std::min(keep, new_vertices.size());
+        REP(i, 0, static_cast<int>(emit)) {
+            os << new_vertices[i] + n0 + 1 << "\n";
+            block_edges -= new_block[i].size();
+        }
+        vertices.assign(new_vertices.begin() + static_cast<long>(emit), new_vertices.end());
+        block.assign(std::make_move_iterator(new_block.begin() + static_cast<long>(emit)),
+                     std::make_move_iterator(new_block.end()));
+    };
+    edge e;
+    bool has_edge = in.next(e);
+    REP(r, 0, n1) {
+        vertices.push_back(order[r]);
+        block.emplace_back();
+        for (; has_edge && e.key == static_cast<uint32_t>(r); has_edge = in.next(e))
+            block.back().push_back(static_cast<int>(e.u));
+        block_edges += block.back().size();
+        if (SZ(vertices) >= window || block_edges > max_edges)
+            flush(vertices.size() / 2);
+    }
+    flush(0);
+}
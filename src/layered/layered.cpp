@@ -0,0 +1,156 @@
+#include <algorithm>
+#include <sstream>
+#include <thread>
+
+#include "../common/context.hpp"
+#include "../common/crossings.hpp"
+#include "../common/memory_budget.hpp"
+#include "../common/trace.hpp"
+#include "../exact/exact.hpp"
+#include "../heuristic/heuristic.hpp"
+#include "layered.hpp"
+
+std::istream &operator>>(std::istream &is, layered_graph &g) {
+    while (is.peek() != 'p' && is.peek() != std::char_traits<char>::eof())
+        is.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    std::string header;
+    std::getline(is, header);
+    std::stringstream ss(header);
+    char p = 0;
+    std::string format;
+    int k = 0, m = 0;
+    ss >> p >> format >> k >> m;
+    if (!ss || p != 'p' || format != "layered" || k < 1 || m < 0)
+        throw std::invalid_argument("Invalid layered graph format");
+    g.offset.assign(k + 1, 0);
+    REP(l, 0, k) {
+        int size = -1;
+        if (!(is >> size) || size < 0 || size > std::numeric_limits<int>::max() - g.offset[l])
+            throw std::invalid_argument("Invalid layer size");
+        g.offset[l + 1] = g.offset[l] + size;
+    }
+    auto layer = [&](int v) { return int(std::ranges::upper_bound(g.offset, v) - g.offset.begin()) - 1; };
+    g.up.assign(g.offset[k], {});
+    g.down.assign(g.offset[k], {});
+    REP(i, 0, m) {
+        int u = 0, v = 0;
+        is >> u >> v;
+        u--, v--;
+        if (!is || u < 0 || u >= g.offset[k] || v < 0 || v >= g.offset[k])
+            throw std::invalid_argument("Invalid edge");
+        if (layer(u) > layer(v))
+            std::swap(u, v);
+        if (layer(u) + 1 != layer(v))
+            throw std::invalid_argument("Edge between non-consecutive layers");
+        g.down[u].push_back(v);
+        g.up[v].push_back(u);
+    }
+    return is;
+}
+
+/**
+ * @brief The one-sided instance of layer l against the fixed neighbouring layer
+ *
+ * @details Left vertices are the positions in order[fixed], right vertices the local indices of layer l.
+ */
+instance sweep::pair(const layered_graph &g, const std::vector<vi> &order, int l, int fixed) {
+    instance inst(g.size(fixed), g.size(l));
+    vi position(g.size(fixed));
+    REP(i, 0, g.size(fixed)) position[order[fixed][i]] = i;
+    const vvi &adj = fixed < l ? g.up : g.down;
+    REP(v, 0, g.size(l)) {
+        for (int u : adj[g.offset[l] + v]) {
+            int x = position[u - g.offset[fixed]];
+            inst.neighbors[v].push_back(x);
+            inst.back_neighbors[x].push_back(v);
+        }
+        std::ranges::sort(inst.neighbors[v]);
+    }
+    REP(x, 0, inst.n0) std::ranges::sort(inst.back_neighbors[x]);
+    return inst;
+}
+
+crint sweep::count(const layered_graph &g, const std::vector<vi> &order) {
+    crint cr = 0;
+    REP(l, 1, g.layers()) cr += crossings::count(pair(g, order, l, l - 1), order[l]);
+    return cr;
+}
+
+/**
+ * @brief Layer-by-layer sweep for k-layer crossing minimization
+ *
+ * @param order Initial order of every layer (local indices), used as warm start
+ * @param e One-sided solver applied to every layer pair
+ * @param seconds Overall time budget
+ * @param parallel Reorder all layers of one parity at once instead of one after the other
+ * @return The best layering found
+ *
+ * @details Alternates down sweeps (layer l against l - 1) and up sweeps (layer l against l + 1). A layer only takes
+ * the new order if it reduces its crossings with both neighbouring layers, so the total never increases.
+ * Stops after a few rounds of a down and up sweep without improving the total, or when the budget is exhausted.
+ */
+std::vector<vi> sweep::solve(const layered_graph &g, std::vector<vi> order, engine e, double seconds,
+                             bool parallel) {
+    TRACE_SCOPE("sweep::solve");
+    context::scope limit(seconds);
+    const int k = g.layers();
+    auto reorder = [&](int l, int fixed) {
+        instance inst = pair(g, order, l, fixed);
+        vi p;
+        if (e == engine::exact)
+            p = exact::solve(inst);
+        else
+            p = heuristic::quick(inst);
+        // Parallel sweeps hold a matrix per layer, a layer whose matrix does not fit the budget keeps quick's order
+        auto lease = e == engine::local && inst.n1 <= 5000 ? memory_budget::acquire(crossings::matrix_bytes(inst))
+                                                           : memory_budget::lease();
+        if (lease) {
+            cmatrix C = crossings::matrix(inst);
+            vi q = order[l];
+            heuristic::greedy_switch(p, C);
+            heuristic::greedy_switch(q, C);
+            if (auto cost = crossings::count(C, {p, q}); cost[1] < cost[0])
+                p = q;
+        }
+        // Accept only if the crossings with both neighbouring layers strictly decrease, which keeps the sweep monotone
+        instance other = fixed == l - 1 ? (l + 1 < k ? pair(g, order, l, l + 1) : instance(0, inst.n1))
+                                        : (l > 0 ? pair(g, order, l, l - 1) : instance(0, inst.n1));
+        if (crossings::count(inst, p) + crossings::count(other, p) <
+            crossings::count(inst, order[l]) + crossings::count(other, order[l]))
+            order[l] = p;
+    };
+    auto pass = [&](bool down) {
+        if (!parallel) {
+            if (down)
+                REP(l, 1, k) reorder(l, l - 1);
+            else
+                for (int l = k - 2; l >= 0; l--)
+                    reorder(l, l + 1);
+            return;
+        }
+        REP(parity, 0, 2) {
+            std::vector<std::thread> workers;
+            for (int l = down ? 1 + parity : parity; l < (down ? k : k - 1); l += 2)
+                workers.emplace_back([&, l, ctx = context::current()] {
+                    context::current() = ctx;
+                    reorder(l, down ? l - 1 : l + 1);
+                });
+            for (auto &worker : workers)
+                worker.join();
+        }
+    };
+
+    std::vector<vi> best = order;
+    crint best_cost = count(g, order);
+    for (int stale = 0; stale < 3 && !context::current().expired();) {
+        pass(true);
+        pass(false);
+        crint cost = count(g, order);
+        TRACE_COUNT("sweep::solve.rounds", 1);
+        if (cost < best_cost)
+            best_cost = cost, best = order, stale = 0;
+        else
+            stale++;
+    }
+    return best;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+
+#include "../common/instance.hpp"
+#include "../common/macros.hpp"
+
+/**
+ * Input format:
+ *   p layered <k> <m>
+ *   <n_1> ... <n_k>
+ *   followed by m lines "u v" with 1-based vertex ids, where layer l holds the ids after the first n_1 + ... + n_{l-1}
+ *   and every edge joins two consecutive layers.
+ */
+struct layered_graph {
+    vi offset; // layer l holds the vertices offset[l], ..., offset[l + 1] - 1
+    vvi up, down;
+
+    [[nodiscard]] int layers() const { return SZ(offset) - 1; }
+    [[nodiscard]] int size(int l) const { return offset[l + 1] - offset[l]; }
+};
+
+std::istream &operator>>(std::istream &is, layered_graph &g);
+
+struct sweep {
+    enum class engine { quick, local, exact };
+
+    static instance pair(const layered_graph &g, const std::vector<vi> &order, int l, int fixed);
+    static crint count(const layered_graph &g, const std::vector<vi> &order);
+    static std::vector<vi> solve(const layered_graph &g, std::vector<vi> order, engine e, double seconds,
+                                 bool parallel);
+};
@@ -1,19 +1,55 @@
+#include <numeric>
+
+#include "../common/config.hpp"
 #include "../common/crossings.hpp"
-#include "../common/penalty_graph.hpp"
+#include "../common/memory_budget.hpp"
+#include "../common/trace.hpp"
 #include "../graph/graph.hpp"
 #include "reduction.hpp"
 
-vi reduction::components(const instance &inst, const slvr &solve) {
+/**
+ * @brief Strongly connected components of the penalty graph, in topological order
+ *
+ * @details Solving every component on its own and concatenating the orders in this sequence is optimal, so each
+ * component is a block of the final order that does not depend on the others. If the crossing matrix does not fit
+ * the memory budget, all vertices form a single block.
+ */
+vvi reduction::blocks(const instance &inst) {
+    auto matrix = memory_budget::acquire(crossings::matrix_bytes(inst));
+    if (!matrix) {
+        vvi all(1, vi(inst.n1));
+        std::iota(ALL(all[0]), 0);
+        return all;
+    }
     cmatrix c = crossings::matrix(inst);
-    vvi adj = graph::matrix_to_list(penalty_graph(inst, c, false));
+    // Penalty graph without presolve: i -> j iff placing i before j is strictly cheaper
+    graph::csr adj;
+    adj.offsets.reserve(inst.n1 + 1);
+    REP(i, 0, inst.n1) {
+        REP(j, 0, inst.n1) if (c[j][i] > c[i][j]) adj.targets.push_back(j);
+        adj.offsets.push_back(SZ(adj.targets));
+    }
     vi comp;
-    int ncomps = graph::sorted_scc(adj, comp);
+    int ncomps = graph::sorted_scc(adj, comp, config::global().threads);
+    TRACE_COUNT("reduction::components.components", ncomps);
     vvi components(ncomps);
     REP(i, 0, SZ(comp)) components[comp[i]].push_back(i);
+    return components;
+}
+
+vi reduction::components(const instance &inst, const slvr &solve) {
+    TRACE_SCOPE("reduction::components");
+    vvi components = blocks(inst);
+    auto parts = split(inst, components);
     vi p;
-    for (const auto &component : components) {
-        vi q = subgraph(inst, component, solve);
-        p.insert(p.end(), ALL(q));
+    p.reserve(inst.n1);
+    REP(k, 0, SZ(components)) {
+        if (SZ(components[k]) == 1) {
+            p.push_back(components[k][0]);
+            continue;
+        }
+        for (int u : solve(parts[k]))
+            p.push_back(components[k][u]);
     }
     return p;
 }
@@ -1,6 +1,8 @@
+#include "../common/trace.hpp"
 #include "reduction.hpp"
 
 vi reduction::isolated(const instance &inst, const slvr &solve) {
+    TRACE_SCOPE("reduction::isolated");
     std::vector<int> isolated, remaining;
     REP(v, 0, inst.n1) {
         if (inst.neighbors[v].empty())
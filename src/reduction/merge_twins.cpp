@@ -1,17 +1,24 @@
+#include "../common/trace.hpp"
 #include "reduction.hpp"
 
 #include <algorithm>
 #include <map>
 
-vi reduction::merge_twins(const instance &inst, const slvr &solve) {
+// Classes of right vertices with equal neighbour lists, ordered by neighbour list
+vvi reduction::twins(const instance &inst) {
     std::map<std::vector<int>, std::vector<int>> twins;
     REP(v, 0, inst.n1)
     twins[inst.neighbors[v]].push_back(v);
-    instance reduced(inst.n0, SZ(twins));
     vvi partitions;
     partitions.reserve(SZ(twins));
     for (auto &[neighbors, vertices] : twins)
-        partitions.push_back(vertices);
+        partitions.push_back(std::move(vertices));
+    return partitions;
+}
+
+// The instance with right vertex u standing for all of partitions[u], adjacent to the union of their edges
+instance reduction::merge(const instance &inst, const vvi &partitions) {
+    instance reduced(inst.n0, SZ(partitions));
     REP(u, 0, reduced.n1) {
         for (int v : partitions[u])
             reduced.neighbors[u].insert(reduced.neighbors[u].end(), ALL(inst.neighbors[v]));
@@ -20,6 +27,14 @@ vi reduction::merge_twins(const instance &inst, const slvr &solve) {
     }
     REP(i, 0, reduced.n0) std::sort(ALL(reduced.back_neighbors[i]));
     REP(i, 0, reduced.n1) std::sort(ALL(reduced.neighbors[i]));
+    return reduced;
+}
+
+vi reduction::merge_twins(const instance &inst, const slvr &solve) {
+    TRACE_SCOPE("reduction::merge_twins");
+    vvi partitions = twins(inst);
+    instance reduced = merge(inst, partitions);
+    TRACE_COUNT("reduction::merge_twins.merged", inst.n1 - reduced.n1);
     vi p = solve(reduced);
     vi sol;
     sol.reserve(inst.n1);
@@ -0,0 +1,15 @@
+#include "reduction.hpp"
+
+/**
+ * @brief All reductions in the order exact::solve applies them
+ *
+ * @details Isolated vertices are set aside and twins merged, then every component is solved on its own after merging
+ * the twins that only appear once the component is cut out. solve gets the remaining blocks.
+ */
+vi reduction::reduce(const instance &inst, const slvr &solve) {
+    return isolated(inst, [&](const instance &inst) {
+        return merge_twins(inst, [&](const instance &inst) {
+            return components(inst, [&](const instance &inst) { return merge_twins(inst, solve); });
+        });
+    });
+}
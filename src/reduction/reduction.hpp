@@ -6,6 +6,11 @@
 struct reduction {
     static vi isolated(const instance &inst, const slvr &solve);
     static vi merge_twins(const instance &inst, const slvr &solve);
+    static vvi twins(const instance &inst);
+    static instance merge(const instance &inst, const vvi &partitions);
     static vi components(const instance &inst, const slvr &solve);
+    static vvi blocks(const instance &inst);
     static vi subgraph(const instance &inst, const vi &vertices, const slvr &solve);
+    static std::vector<instance> split(const instance &inst, const vvi &parts);
+    static vi reduce(const instance &inst, const slvr &solve);
 };
@@ -0,0 +1,56 @@
+#include "../common/trace.hpp"
+#include "reduction.hpp"
+
+/**
+ * @brief Sub-instances induced by disjoint sets of right vertices, built in one pass
+ *
+ * @param parts Disjoint lists of right vertices; vertex parts[k][u] becomes right vertex u of the k-th sub-instance.
+ * Right vertices in no part are dropped.
+ * @return One instance per part, each exactly as reduction::subgraph builds it for that part
+ *
+ * @details Complexity: O(n0 + n1 + m + parts) time and memory
+ * Left vertices without a neighbour in a part are dropped from it, and consecutive left vertices whose only neighbour
+ * in the part is the same right vertex are merged. The left vertices are visited once in order, and every part keeps
+ * its own merge state, so no part ever scans the full left side.
+ */
+std::vector<instance> reduction::split(const instance &inst, const vvi &parts) {
+    TRACE_SCOPE("reduction::split");
+    const int k = SZ(parts);
+    vi part(inst.n1, -1), local(inst.n1);
+    std::vector<instance> res(k);
+    REP(c, 0, k) {
+        res[c] = instance(0, SZ(parts[c]));
+        REP(u, 0, SZ(parts[c])) part[parts[c][u]] = c, local[parts[c][u]] = u;
+    }
+
+    // Per part: the right vertex the previous left vertex was merged into (-1 if none), and scratch for the current one
+    vi prev(k, -1), single(k), left(k), seen(k, -1), touched;
+    REP(i, 0, inst.n0) {
+        touched.clear();
+        for (int v : inst.back_neighbors[i]) {
+            int c = part[v];
+            if (c < 0)
+                continue;
+            if (seen[c] != i)
+                seen[c] = i, single[c] = v, touched.push_back(c);
+            else if (single[c] != v)
+                single[c] = -1;
+        }
+        for (int c : touched) {
+            if (single[c] >= 0 && prev[c] == single[c]) {
+                left[c] = res[c].n0 - 1;
+                continue;
+            }
+            left[c] = res[c].n0++;
+            prev[c] = single[c];
+        }
+        for (int v : inst.back_neighbors[i])
+            if (int c = part[v]; c >= 0)
+                res[c].neighbors[local[v]].push_back(left[c]);
+    }
+    for (auto &sub : res) {
+        sub.back_neighbors.assign(sub.n0, {});
+        REP(u, 0, sub.n1) for (int x : sub.neighbors[u]) sub.back_neighbors[x].push_back(u);
+    }
+    return res;
+}